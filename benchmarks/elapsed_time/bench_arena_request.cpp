@@ -0,0 +1,105 @@
+/**
+ *  @file bench_arena_request.cpp
+ *  Simulates requests which allocate scratch objects of random sizes
+ *  (16 - 128 bytes) and free all of them when the request ends.
+ *  Allocation and deallocation is done with `MonotonicArena` (which is reset
+ *  at the end of every request), `GlobalLinkedPool` (one per size class, as
+ *  in `custom_new`) and `new/delete`.
+ *  @par
+ *  The first command line argument sets the number of requests and the
+ *  second one the number of objects of each request.
+ *  @par
+ *  The results will be written to a file called **arena_time_taken.json**.
+ *  @see JSONWriter
+ */
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Utility.h"
+#include "rpools/allocators/GlobalLinkedPool.hpp"
+#include "rpools/allocators/MonotonicArena.hpp"
+
+using rpools::GlobalLinkedPool;
+using rpools::MonotonicArena;
+
+/** The size classes of the scratch objects. */
+const size_t CLASS_SIZE = 16;
+const size_t NUM_OF_CLASSES = 8;
+
+int main(int argc, char *argv[]) {
+    size_t REQUESTS = argc > 1 ? std::stoul(argv[1]) : 1000;
+    size_t OBJECTS = argc > 2 ? std::stoul(argv[2]) : 1000;
+    JSONWriter j("arena_time_taken.json", REQUESTS * OBJECTS);
+    std::mt19937 gen(42);
+    std::vector<size_t> classes(OBJECTS);
+    for (auto& sizeClass : classes) {
+        sizeClass = gen() % NUM_OF_CLASSES;
+    }
+    std::vector<void*> ptrs(OBJECTS);
+
+    // the time of a request is split into its allocations and the
+    // deallocations at its end
+    float allocTime = 0;
+    float deallocTime = 0;
+    {
+        MonotonicArena arena;
+        for (size_t r = 0; r < REQUESTS; ++r) {
+            std::clock_t start = std::clock();
+            for (size_t i = 0; i < OBJECTS; ++i) {
+                ptrs[i] = arena.allocate((classes[i] + 1) * CLASS_SIZE);
+            }
+            allocTime += std::clock() - start;
+            start = std::clock();
+            arena.reset();
+            deallocTime += std::clock() - start;
+        }
+    }
+    j.addAllocation("MonotonicArena", allocTime / (CLOCKS_PER_SEC / 1000));
+    j.addDeallocation("MonotonicArena",
+                      deallocTime / (CLOCKS_PER_SEC / 1000));
+
+    allocTime = 0;
+    deallocTime = 0;
+    {
+        std::vector<std::unique_ptr<GlobalLinkedPool>> pools;
+        for (size_t c = 0; c < NUM_OF_CLASSES; ++c) {
+            pools.emplace_back(new GlobalLinkedPool((c + 1) * CLASS_SIZE));
+        }
+        for (size_t r = 0; r < REQUESTS; ++r) {
+            std::clock_t start = std::clock();
+            for (size_t i = 0; i < OBJECTS; ++i) {
+                ptrs[i] = pools[classes[i]]->allocate();
+            }
+            allocTime += std::clock() - start;
+            start = std::clock();
+            for (size_t i = 0; i < OBJECTS; ++i) {
+                pools[classes[i]]->deallocate(ptrs[i]);
+            }
+            deallocTime += std::clock() - start;
+        }
+    }
+    j.addAllocation("GlobalLinkedPool", allocTime / (CLOCKS_PER_SEC / 1000));
+    j.addDeallocation("GlobalLinkedPool",
+                      deallocTime / (CLOCKS_PER_SEC / 1000));
+
+    allocTime = 0;
+    deallocTime = 0;
+    for (size_t r = 0; r < REQUESTS; ++r) {
+        std::clock_t start = std::clock();
+        for (size_t i = 0; i < OBJECTS; ++i) {
+            ptrs[i] = ::operator new((classes[i] + 1) * CLASS_SIZE);
+        }
+        allocTime += std::clock() - start;
+        start = std::clock();
+        for (size_t i = 0; i < OBJECTS; ++i) {
+            ::operator delete(ptrs[i]);
+        }
+        deallocTime += std::clock() - start;
+    }
+    j.addAllocation("new/delete", allocTime / (CLOCKS_PER_SEC / 1000));
+    j.addDeallocation("new/delete", deallocTime / (CLOCKS_PER_SEC / 1000));
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ *  @file bench_buddy_order.cpp
+ *  Allocates a number of power of 2 buffers (4 KiB - 1 MiB) and deallocates
+ *  them in a random order.
+ *  Allocation and deallocation is done with `BuddyAllocator`,
+ *  `aligned_alloc/free` and `custom_new/custom_delete`. `custom_new` serves
+ *  the 4 KiB buffers from its mid-size tier (up to 4096 bytes) and the
+ *  larger buffers from its large object path (`malloc`).
+ *  @par
+ *  A command line argument can be passed to set the number of buffers
+ *  that will be created and destroyed.
+ *  @par
+ *  The results will be written to a file called **buddy_time_taken.json**.
+ *  @see JSONWriter
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Utility.h"
+#include "rpools/allocators/BuddyAllocator.hpp"
+#include "rpools/custom_new/custom_new_delete.hpp"
+
+using rpools::BuddyAllocator;
+
+/** The smallest buffer is 2^MIN_LOG2 bytes. */
+const size_t MIN_LOG2 = 12;
+/** The largest buffer is 2^MAX_LOG2 bytes. */
+const size_t MAX_LOG2 = 20;
+
+/**
+ *  Allocates buffers of the given sizes with `t_alloc` and deallocates them
+ *  in the given order with `t_dealloc`.
+ *  @param t_sizes the size of each buffer
+ *  @param t_order the order of the deallocations
+ *  @param j the JSONWriter which records the speed
+ *  @param t_name the name of the allocator
+ */
+template<typename A, typename D>
+void benchAllocator(const std::vector<size_t>& t_sizes,
+                    const std::vector<size_t>& t_order, JSONWriter& j,
+                    const std::string& t_name, A t_alloc, D t_dealloc) {
+    std::vector<void*> bufs(t_sizes.size());
+    std::clock_t start = std::clock();
+    for (size_t i = 0; i < t_sizes.size(); ++i) {
+        bufs[i] = t_alloc(t_sizes[i]);
+        // touch the buffer like an I/O buffer would be
+        static_cast<char*>(bufs[i])[0] = 1;
+    }
+    j.addAllocation(t_name, start);
+
+    start = std::clock();
+    for (size_t i : t_order) {
+        t_dealloc(bufs[i], t_sizes[i]);
+    }
+    j.addDeallocation(t_name, start);
+}
+
+int main(int argc, char *argv[]) {
+    size_t BOUND = argc > 1 ? std::stoul(argv[1]) : 1000;
+    JSONWriter j("buddy_time_taken.json", BOUND);
+    std::mt19937 gen(42);
+    std::vector<size_t> sizes(BOUND);
+    std::vector<size_t> order(BOUND);
+    size_t totalSize = 0;
+    for (size_t i = 0; i < BOUND; ++i) {
+        sizes[i] = size_t(1) << (MIN_LOG2 + gen() % (MAX_LOG2 - MIN_LOG2 + 1));
+        totalSize += sizes[i];
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), gen);
+    {
+        // a buddy allocator wastes at most half of its region
+        BuddyAllocator buddy(2 * totalSize);
+        benchAllocator(sizes, order, j, "BuddyAllocator",
+                       [&buddy](size_t t_size) {
+                           return buddy.allocate(t_size);
+                       },
+                       [&buddy](void* t_ptr, size_t) {
+                           buddy.deallocate(t_ptr);
+                       });
+    }
+    benchAllocator(sizes, order, j, "aligned_alloc",
+                   [](size_t t_size) {
+                       return aligned_alloc(rpools::getPageSize(), t_size);
+                   },
+                   [](void* t_ptr, size_t) { free(t_ptr); });
+    benchAllocator(sizes, order, j, "custom_new",
+                   [](size_t t_size) { return custom_new(t_size); },
+                   [](void* t_ptr, size_t) { custom_delete(t_ptr); });
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ *  @file bench_contention.cpp
+ *  Measures `MemoryPool`, whose free list is protected by a spinlock,
+ *  against `LockFreeMemoryPool` when several threads allocate and
+ *  deallocate `TestObject`s from the same pool at the same time.
+ *  @par
+ *  Every thread repeatedly allocates a batch of objects and then
+ *  deallocates all of them. The recorded times are the wall clock times of
+ *  the allocations and of the deallocations, averaged over the threads.
+ *  @par
+ *  The first command line argument sets the number of threads, the second
+ *  one the number of objects that each thread allocates and the third one
+ *  the size of a batch.
+ *  @par
+ *  The results will be written to a file called
+ *  **contention_time_taken.json**.
+ *  @see JSONWriter
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Utility.h"
+#include "unit_test/TestObject.h"
+#include "rpools/allocators/LockFreeMemoryPool.hpp"
+#include "rpools/allocators/MemoryPool.h"
+
+using rpools::LockFreeMemoryPool;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+/**
+ *  @return the number of ms from `t_start` until now.
+ */
+float elapsed(Clock::time_point t_start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - t_start)
+        .count();
+}
+
+/**
+ *  Runs `threadsNo` threads which allocate `objects` `TestObject`s each in
+ *  batches of `batch` objects, using a single pool.
+ *  @tparam T the type of the pool allocator
+ *  @param j the JSONWriter which records the speed
+ *  @param name the name of the allocator in the json file
+ */
+template<typename T>
+void benchPool(size_t threadsNo, size_t objects, size_t batch,
+               JSONWriter& j, const std::string& name) {
+    T pool;
+    vector<float> allocTimes(threadsNo, 0);
+    vector<float> deallocTimes(threadsNo, 0);
+    vector<std::thread> threads;
+    for (size_t t = 0; t < threadsNo; ++t) {
+        threads.emplace_back([&, t]() {
+            vector<TestObject*> objs(batch);
+            for (size_t done = 0; done < objects; done += batch) {
+                Clock::time_point start = Clock::now();
+                for (size_t i = 0; i < batch; ++i) {
+                    objs[i] = pool.allocate();
+                }
+                allocTimes[t] += elapsed(start);
+                start = Clock::now();
+                for (size_t i = 0; i < batch; ++i) {
+                    pool.deallocate(objs[i]);
+                }
+                deallocTimes[t] += elapsed(start);
+            }
+        });
+    }
+    float allocTime = 0;
+    float deallocTime = 0;
+    for (size_t t = 0; t < threadsNo; ++t) {
+        threads[t].join();
+        allocTime += allocTimes[t];
+        deallocTime += deallocTimes[t];
+    }
+    j.addAllocation(name, allocTime / threadsNo);
+    j.addDeallocation(name, deallocTime / threadsNo);
+}
+
+int main(int argc, char *argv[]) {
+    size_t THREADS = argc > 1 ? std::stoul(argv[1]) : 4;
+    size_t OBJECTS = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    size_t BATCH = argc > 3 ? std::stoul(argv[3]) : 64;
+    JSONWriter j("contention_time_taken.json", THREADS * OBJECTS);
+    benchPool<MemoryPool<TestObject>>(THREADS, OBJECTS, BATCH, j,
+                                      "MemoryPool");
+    benchPool<LockFreeMemoryPool<TestObject>>(THREADS, OBJECTS, BATCH, j,
+                                              "LockFreeMemoryPool");
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ *  @file bench_mid_contention.cpp
+ *  Measures the mid-size tier of `custom_new`, which serves allocations of
+ *  129 to 4096 bytes, against `malloc` when several threads allocate and
+ *  deallocate at the same time.
+ *  @par
+ *  Every thread repeatedly allocates a batch of blocks of random sizes and
+ *  then deallocates all of them. The recorded times are the wall clock
+ *  times of the allocations and of the deallocations, averaged over the
+ *  threads.
+ *  @par
+ *  The first command line argument sets the number of threads, the second
+ *  one the number of blocks that each thread allocates and the third one
+ *  the size of a batch.
+ *  @par
+ *  The results will be written to a file called
+ *  **mid_contention_time_taken.json**.
+ *  @see JSONWriter
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Utility.h"
+#include "rpools/custom_new/custom_new_delete.hpp"
+
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+/**
+ *  @return the number of ms from `t_start` until now.
+ */
+float elapsed(Clock::time_point t_start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - t_start)
+        .count();
+}
+
+/**
+ *  Runs `threadsNo` threads which allocate `blocks` blocks each in batches
+ *  of `batch` blocks.
+ *  @param alloc allocates a block of the given size
+ *  @param dealloc deallocates a block
+ *  @param j the JSONWriter which records the speed
+ *  @param name the name of the allocator in the json file
+ */
+template<typename A, typename D>
+void benchMid(size_t threadsNo, size_t blocks, size_t batch, A alloc,
+              D dealloc, JSONWriter& j, const std::string& name) {
+    vector<float> allocTimes(threadsNo, 0);
+    vector<float> deallocTimes(threadsNo, 0);
+    vector<std::thread> threads;
+    for (size_t t = 0; t < threadsNo; ++t) {
+        threads.emplace_back([&, t]() {
+            // every allocator gets the same sizes in the same order
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<size_t> dist(129, 4096);
+            vector<size_t> sizes(batch);
+            vector<void*> ptrs(batch);
+            for (size_t done = 0; done < blocks; done += batch) {
+                for (size_t i = 0; i < batch; ++i) {
+                    sizes[i] = dist(gen);
+                }
+                Clock::time_point start = Clock::now();
+                for (size_t i = 0; i < batch; ++i) {
+                    ptrs[i] = alloc(sizes[i]);
+                }
+                allocTimes[t] += elapsed(start);
+                start = Clock::now();
+                for (size_t i = 0; i < batch; ++i) {
+                    dealloc(ptrs[i]);
+                }
+                deallocTimes[t] += elapsed(start);
+            }
+        });
+    }
+    float allocTime = 0;
+    float deallocTime = 0;
+    for (size_t t = 0; t < threadsNo; ++t) {
+        threads[t].join();
+        allocTime += allocTimes[t];
+        deallocTime += deallocTimes[t];
+    }
+    j.addAllocation(name, allocTime / threadsNo);
+    j.addDeallocation(name, deallocTime / threadsNo);
+}
+
+int main(int argc, char *argv[]) {
+    size_t THREADS = argc > 1 ? std::stoul(argv[1]) : 4;
+    size_t BLOCKS = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    size_t BATCH = argc > 3 ? std::stoul(argv[3]) : 64;
+    JSONWriter j("mid_contention_time_taken.json", THREADS * BLOCKS);
+    benchMid(THREADS, BLOCKS, BATCH,
+             [](size_t t_size) { return custom_new(t_size); },
+             [](void* t_ptr) { custom_delete(t_ptr); }, j, "custom_new");
+    benchMid(THREADS, BLOCKS, BATCH,
+             [](size_t t_size) { return std::malloc(t_size); },
+             [](void* t_ptr) { std::free(t_ptr); }, j, "malloc");
+    return 0;
+}
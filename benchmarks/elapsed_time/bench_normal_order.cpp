@@ -2,8 +2,8 @@
  *  @file bench_normal_order.cpp
  *  Allocates a number of `TestObject`s on the heap and deallocates
  *  them in the same order.
- *  Allocation and deallocation is done with `new/delete`, `LinkedPools`
- *  `MemoryPool` and `boost::object_pool`.
+ *  Allocation and deallocation is done with `new/delete`, `LinkedPools`,
+ *  `BitPool`, `MemoryPool` and `boost::object_pool`.
  *  @par
  *  A command line argument can be passed to set the number of `TestObject`s
  *  that will be created and destroyed.
@@ -23,8 +23,15 @@
 #endif
 #include "rpools/allocators/MemoryPool.h"
 #include "rpools/allocators/LinkedPool.hpp"
+#include "rpools/allocators/BitPool.hpp"
+
+// a template template parameter with a single parameter does not match
+// MemoryPool<T, BlockSize> before C++17
+template<typename T>
+using PageMemoryPool = MemoryPool<T>;
 
 using rpools::LinkedPool;
+using rpools::BitPool;
 
 /**
  *  Allocate and deallocate a number of `TestObject`s by using a pool allocator.
@@ -93,7 +100,10 @@ int main(int argc, char *argv[]) {
         benchPool<LinkedPool>(BOUND, j, "LinkedPool");
     }
     {
-        benchPool<MemoryPool>(BOUND, j, "MemoryPool");
+        benchPool<BitPool>(BOUND, j, "BitPool");
+    }
+    {
+        benchPool<PageMemoryPool>(BOUND, j, "MemoryPool");
     }
 #ifdef INCLUDE_BOOST
     {
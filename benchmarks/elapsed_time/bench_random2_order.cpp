@@ -12,7 +12,7 @@
  *  (de)allocate in the same order.
  *  @par
  *  Allocation and deallocation is done with `new/delete`, `LinkedPools`,
- *  `MemoryPool` and `boost::object_pool`.
+ *  `BitPool`, `MemoryPool` and `boost::object_pool`.
  *  @par
  *  The results will be written to a file called **random2_time_taken.json**
  *  @see JSONWriter
@@ -32,8 +32,15 @@
 #endif
 #include "rpools/allocators/MemoryPool.h"
 #include "rpools/allocators/LinkedPool.hpp"
+#include "rpools/allocators/BitPool.hpp"
+
+// a template template parameter with a single parameter does not match
+// MemoryPool<T, BlockSize> before C++17
+template<typename T>
+using PageMemoryPool = MemoryPool<T>;
 
 using rpools::LinkedPool;
+using rpools::BitPool;
 using std::pair;
 using std::make_pair;
 using std::vector;
@@ -73,9 +80,9 @@ float deallocateN(size_t index, vector<TestObject*>& vec) {
  *  @param lp the pool allocator
  *  @return The number of ms it took to allocate the `TestObject`s.
  */
-template<template <typename> class T>
+template<typename T>
 float allocateN(const pair<size_t, size_t>& range, vector<TestObject*>& vec,
-               T<TestObject>& lp) {
+               T& lp) {
     std::clock_t start = std::clock();
     for (size_t i = range.first; i < range.second; ++i) {
         vec[i] = (TestObject*) lp.allocate();
@@ -90,8 +97,8 @@ float allocateN(const pair<size_t, size_t>& range, vector<TestObject*>& vec,
  *  @param vec the vector from which the `TestObject` is deallocated
  *  @return The number of ms it took to deallocate the `TestObject`.
  */
-template<template <typename> class T>
-float deallocateN(size_t index, vector<TestObject*>& vec, T<TestObject>& lp) {
+template<typename T>
+float deallocateN(size_t index, vector<TestObject*>& vec, T& lp) {
     std::clock_t start = std::clock();
     lp.deallocate(vec[index]);
     return (std::clock() - start) / (double)(CLOCKS_PER_SEC / 1000);
@@ -253,7 +260,10 @@ int main(int argc, char *argv[]) {
         benchPool<LinkedPool>(BOUND, j, order, "LinkedPool");
     }
     {
-        benchPool<MemoryPool>(BOUND, j, order, "MemoryPool");
+        benchPool<BitPool>(BOUND, j, order, "BitPool");
+    }
+    {
+        benchPool<PageMemoryPool>(BOUND, j, order, "MemoryPool");
     }
 #ifdef INCLUDE_BOOST
     {
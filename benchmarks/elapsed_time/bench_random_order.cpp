@@ -2,7 +2,7 @@
  *  @file bench_random_order.cpp
  *  Allocates a number of `TestObject`s on the heap and deallocates
  *  them in a random order. Allocation and deallocation is done
- *  with `new/delete`, `LinkedPools`, `MemoryPool` and
+ *  with `new/delete`, `LinkedPools`, `BitPool`, `MemoryPool` and
  *  `boost::object_pool`.
  *  @par
  *  A command line argument can be passed to set the number of `TestObject`s
@@ -23,8 +23,15 @@
 #endif
 #include "rpools/allocators/MemoryPool.h"
 #include "rpools/allocators/LinkedPool.hpp"
+#include "rpools/allocators/BitPool.hpp"
+
+// a template template parameter with a single parameter does not match
+// MemoryPool<T, BlockSize> before C++17
+template<typename T>
+using PageMemoryPool = MemoryPool<T>;
 
 using rpools::LinkedPool;
+using rpools::BitPool;
 using std::vector;
 
 /**
@@ -107,7 +114,10 @@ int main(int argc, char *argv[]) {
         benchPool<LinkedPool>(BOUND, j, randomPos, "LinkedPool");
     }
     {
-        benchPool<MemoryPool>(BOUND, j, randomPos, "MemoryPool");
+        benchPool<BitPool>(BOUND, j, randomPos, "BitPool");
+    }
+    {
+        benchPool<PageMemoryPool>(BOUND, j, randomPos, "MemoryPool");
     }
 #ifdef INCLUDE_BOOST
     {
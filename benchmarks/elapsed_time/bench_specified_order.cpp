@@ -3,7 +3,7 @@
  *  Allocates and deallocates a number of `TestObject`s on the heap in a certain
  *  order.
  *  Allocation and deallocation is done with `new/delete`, `LinkedPools`,
- *  `MemoryPool`, and `boost::object_pool`.
+ *  `BitPool`, `MemoryPool`, and `boost::object_pool`.
  *  @par
  *  A command line argument can be passed to set the number of `TestObject`s
  *  that will be created and destroyed.
@@ -24,8 +24,15 @@
 #endif
 #include "rpools/allocators/MemoryPool.h"
 #include "rpools/allocators/LinkedPool.hpp"
+#include "rpools/allocators/BitPool.hpp"
+
+// a template template parameter with a single parameter does not match
+// MemoryPool<T, BlockSize> before C++17
+template<typename T>
+using PageMemoryPool = MemoryPool<T>;
 
 using rpools::LinkedPool;
+using rpools::BitPool;
 using std::vector;
 
 /**
@@ -66,8 +73,8 @@ float deallocateN(size_t num, vector<TestObject*>& vec) {
  *  @param lp the pool allocator
  *  @return The number of ms it took to allocate `num` `TestObject`s.
  */
-template<template <typename> class T>
-float allocateN(size_t num, vector<TestObject*>& vec, T<TestObject>& lp) {
+template<typename T>
+float allocateN(size_t num, vector<TestObject*>& vec, T& lp) {
     std::clock_t start = std::clock();
     for (size_t i = 0; i < num; ++i) {
         vec.push_back((TestObject*) lp.allocate());
@@ -84,8 +91,8 @@ float allocateN(size_t num, vector<TestObject*>& vec, T<TestObject>& lp) {
  *  @param lp the pool allocator
  *  @return The number of ms it took to deallocate `num` `TestObject`s.
  */
-template<template <typename> class T>
-float deallocateN(size_t num, vector<TestObject*>& vec, T<TestObject>& lp) {
+template<typename T>
+float deallocateN(size_t num, vector<TestObject*>& vec, T& lp) {
     std::clock_t start = std::clock();
     for (size_t i = 0; i < num; ++i) {
         lp.deallocate(vec.back());
@@ -235,7 +242,10 @@ int main(int argc, char *argv[]) {
         benchPool<LinkedPool>(BOUND, j, five, ten, "LinkedPool");
     }
     {
-        benchPool<MemoryPool>(BOUND, j, five, ten, "MemoryPool");
+        benchPool<BitPool>(BOUND, j, five, ten, "BitPool");
+    }
+    {
+        benchPool<PageMemoryPool>(BOUND, j, five, ten, "MemoryPool");
     }
 #ifdef INCLUDE_BOOST
     {
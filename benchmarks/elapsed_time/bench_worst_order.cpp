@@ -3,7 +3,7 @@
  *  Allocates a number of `TestObject`s on the heap and deallocates
  *  them in an order which causes `LinkedPool` to work extra.
  *  Allocation and deallocation is done with `new/delete`, `LinkedPools`,
- *  `MemoryPool` and `boost::object_pool`.
+ *  `BitPool`, `MemoryPool` and `boost::object_pool`.
  *  @par
  *  A command line argument can be passed to set the number of `TestObject`s
  *  that will be created and destroyed.
@@ -20,8 +20,15 @@
 #endif
 #include "rpools/allocators/MemoryPool.h"
 #include "rpools/allocators/LinkedPool.hpp"
+#include "rpools/allocators/BitPool.hpp"
+
+// a template template parameter with a single parameter does not match
+// MemoryPool<T, BlockSize> before C++17
+template<typename T>
+using PageMemoryPool = MemoryPool<T>;
 
 using rpools::LinkedPool;
+using rpools::BitPool;
 using std::vector;
 
 /**
@@ -111,7 +118,10 @@ int main(int argc, char* argv[]) {
         benchPool<LinkedPool>(BOUND, j, POOL_SIZE, MULT, "LinkedPool");
     }
     {
-        benchPool<MemoryPool>(BOUND, j, POOL_SIZE, MULT, "MemoryPool");
+        benchPool<BitPool>(BOUND, j, POOL_SIZE, MULT, "BitPool");
+    }
+    {
+        benchPool<PageMemoryPool>(BOUND, j, POOL_SIZE, MULT, "MemoryPool");
     }
 #ifdef INCLUDE_BOOST
     {
@@ -0,0 +1,56 @@
+/**
+ *  @file macro_json.cpp
+ *  Builds a large JSON document with `nlohmann::json`, serializes it and
+ *  parses it back a number of times. Every JSON value is a separate heap
+ *  allocation, which makes this a good end-to-end allocator workload.
+ *  @par
+ *  Usage: `macro_json [records] [rounds]` (default: 50000 records, 5 rounds)
+ */
+
+#include <iostream>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+using nlohmann::json;
+
+/**
+ *  @param t_records the number of records of the document
+ *  @return a document which resembles a dump of a database table.
+ */
+json makeDocument(size_t t_records) {
+    json doc;
+    doc["name"] = "macro_json";
+    doc["records"] = json::array();
+    for (size_t i = 0; i < t_records; ++i) {
+        json record;
+        record["id"] = i;
+        record["name"] = "record_" + std::to_string(i);
+        record["score"] = i * 0.5;
+        record["active"] = i % 3 == 0;
+        record["tags"] = { "tag" + std::to_string(i % 7),
+                           "tag" + std::to_string(i % 11) };
+        record["owner"] = { { "id", i % 100 },
+                            { "email", "user" + std::to_string(i % 100) +
+                                       "@example.com" } };
+        doc["records"].push_back(std::move(record));
+    }
+    return doc;
+}
+
+int main(int argc, char* argv[]) {
+    size_t RECORDS = argc > 1 ? std::stoul(argv[1]) : 50000;
+    size_t ROUNDS = argc > 2 ? std::stoul(argv[2]) : 5;
+    size_t checksum = 0;
+    std::string text = makeDocument(RECORDS).dump();
+    for (size_t i = 0; i < ROUNDS; ++i) {
+        json doc = json::parse(text);
+        for (auto& record : doc["records"]) {
+            record["score"] = record["score"].get<double>() + 1;
+        }
+        text = doc.dump(i % 2 == 0 ? -1 : 2);
+        checksum += text.size();
+    }
+    std::cout << checksum << std::endl;
+    return 0;
+}
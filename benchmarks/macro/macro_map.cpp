@@ -0,0 +1,61 @@
+/**
+ *  @file macro_map.cpp
+ *  A `std::map` heavy workload: an order book like structure which
+ *  constantly inserts, looks up and erases small nodes.
+ *  @par
+ *  Usage: `macro_map [operations]` (default: 5000000)
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+struct Order {
+    uint64_t id;
+    uint32_t quantity;
+    double price;
+};
+
+int main(int argc, char* argv[]) {
+    size_t OPERATIONS = argc > 1 ? std::stoul(argv[1]) : 5000000;
+    std::mt19937_64 engine(42);
+    // price level -> orders at that level
+    std::map<uint32_t, std::map<uint64_t, Order>> book;
+    uint64_t nextId = 0;
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+        uint32_t level = engine() % 2048;
+        switch (engine() % 4) {
+        case 0:
+        case 1: {
+            // add an order
+            Order order{ nextId, static_cast<uint32_t>(engine() % 100),
+                         level * 0.01 };
+            book[level].emplace(nextId++, order);
+            break;
+        }
+        case 2: {
+            // cancel the oldest order of a level
+            auto it = book.find(level);
+            if (it != book.end()) {
+                it->second.erase(it->second.begin());
+                if (it->second.empty()) {
+                    book.erase(it);
+                }
+            }
+            break;
+        }
+        default: {
+            // match against the best level
+            auto it = book.lower_bound(level);
+            if (it != book.end()) {
+                checksum += it->second.begin()->second.quantity;
+            }
+        }
+        }
+    }
+    std::cout << checksum + book.size() << std::endl;
+    return 0;
+}
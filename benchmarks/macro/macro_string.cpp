@@ -0,0 +1,55 @@
+/**
+ *  @file macro_string.cpp
+ *  A `std::string` heavy workload: generates text, splits it into words,
+ *  counts them in a hash map and sorts the result, like a log processing
+ *  tool would do.
+ *  @par
+ *  Usage: `macro_string [lines] [rounds]` (default: 200000 lines, 5 rounds)
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+int main(int argc, char* argv[]) {
+    size_t LINES = argc > 1 ? std::stoul(argv[1]) : 200000;
+    size_t ROUNDS = argc > 2 ? std::stoul(argv[2]) : 5;
+    std::mt19937 engine(42);
+    size_t checksum = 0;
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        vector<string> lines;
+        lines.reserve(LINES);
+        for (size_t i = 0; i < LINES; ++i) {
+            string line = "request " + std::to_string(engine() % 10000) +
+                " from host-" + std::to_string(engine() % 500) +
+                " took " + std::to_string(engine() % 1000) + "ms";
+            lines.push_back(std::move(line));
+        }
+        std::unordered_map<string, size_t> counts;
+        for (const auto& line : lines) {
+            std::istringstream words(line);
+            string word;
+            while (words >> word) {
+                ++counts[word];
+            }
+        }
+        vector<std::pair<string, size_t>> sorted(counts.begin(), counts.end());
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const std::pair<string, size_t>& a,
+                     const std::pair<string, size_t>& b) {
+                      return a.second > b.second ||
+                          (a.second == b.second && a.first < b.first);
+                  });
+        checksum += sorted.size() + sorted.front().second;
+    }
+    std::cout << checksum << std::endl;
+    return 0;
+}
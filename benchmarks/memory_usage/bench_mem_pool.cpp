@@ -1,20 +1,69 @@
+/**
+ *  @file bench_mem_pool.cpp
+ *  Compares the RSS of `MemoryPool` and `LinkedPool` after a burst of
+ *  allocations.
+ *  @par
+ *  `BOUND` objects are allocated, then all of them except every 1000th are
+ *  deallocated, so that a few objects outlive the burst, and at last the
+ *  survivors are deallocated too. The RSS of the process is printed after
+ *  each step.
+ *  @par
+ *  Usage: `bench_mem_pool [BOUND] [memory|linked]`
+ *  (default: 10000 objects, memory).
+ */
+
+#include <malloc.h>
+#include <iostream>
 #include <string>
 
 #include "unit_test/TestObject.h"
+#include "rpools/allocators/LinkedPool.hpp"
 #include "rpools/allocators/MemoryPool.h"
+#include "rpools/tools/proc_utils.hpp"
 
 #include <vector>
 using std::vector;
 
-int main(int argc, char* argv[]) {
-    size_t BOUND = argc < 2 ? 10000 : std::stoul(argv[1]);
-    MemoryPool<TestObject> lp;
+/**
+ *  Prints the RSS of the process after the freed memory is returned to the
+ *  system.
+ */
+void printRSS(const std::string& t_step) {
+    malloc_trim(0);
+    std::cout << t_step << ": " << getResidentSetSize() << " kB" << std::endl;
+}
+
+template<typename T>
+void burst(size_t BOUND) {
+    T lp;
     vector<TestObject*> objs;
+    printRSS("before");
     for (size_t i = 0; i < BOUND; ++i) {
         objs.push_back(static_cast<TestObject*>(lp.allocate()));
     }
+    printRSS("burst");
+    vector<TestObject*> survivors;
     for (size_t i = 0; i < BOUND; ++i) {
-        lp.deallocate(objs.back());
-        objs.pop_back();
+        if (i % 1000 == 0) {
+            survivors.push_back(objs[i]);
+        } else {
+            lp.deallocate(objs[i]);
+        }
+    }
+    vector<TestObject*>().swap(objs);
+    printRSS("survivors");
+    for (auto obj : survivors) {
+        lp.deallocate(obj);
+    }
+    printRSS("after");
+}
+
+int main(int argc, char* argv[]) {
+    size_t BOUND = argc < 2 ? 10000 : std::stoul(argv[1]);
+    std::string allocator = argc < 3 ? "memory" : argv[2];
+    if (allocator == "linked") {
+        burst<rpools::LinkedPool<TestObject>>(BOUND);
+    } else {
+        burst<MemoryPool<TestObject>>(BOUND);
     }
 }
@@ -0,0 +1,307 @@
+/**
+ *  @file bench_soak.cpp
+ *  A long running benchmark which simulates the allocation pattern of a
+ *  process that runs for weeks, in order to observe how fragmentation
+ *  builds up over time.
+ *  @par
+ *  The simulation is driven by a clock which ticks once per allocation.
+ *  Every tick frees the objects whose lifetime expired and then allocates a
+ *  new object whose lifetime is drawn from a Pareto distribution (most
+ *  objects die young, a few live almost forever). The run goes through
+ *  the following phases:
+ *  * ramp-up (10% of the ticks): objects are only allocated
+ *  * churn (40% of the ticks): steady state with a small objects size mix
+ *  * shift (40% of the ticks): steady state with a larger objects size mix
+ *  * drain: the remaining objects are freed in order of death
+ *  @par
+ *  Usage: `bench_soak [ticks] [checkpoints]`
+ *  (default: 10000000 ticks, 50 checkpoints).
+ *  @par
+ *  `bench_soak` allocates with `custom_new` and `bench_soak_malloc` runs the
+ *  same workload with `malloc`. `bench_soak_malloc` is built from this file
+ *  with `SOAK_MALLOC` and is not linked with `libcustomnew`, so that the
+ *  allocations of the benchmark itself (the heap of live objects and the
+ *  results) are not made in the pools either.
+ *  @par
+ *  Every object is allocated with the alignment that `operator new` uses
+ *  for its size (@see rpools::getNaturalAlignment), so the objects land in
+ *  the same size classes as in a program that uses `libcustomnew`.
+ *  @par
+ *  At every checkpoint the RSS of the process, the number of pages held by
+ *  each size class and the occupancy distribution of those pages are
+ *  recorded. During the drain the clock is stopped, so the checkpoints of
+ *  the drain are all at the last tick of the shift and record the number
+ *  of objects that were drained instead. The results are written to a file
+ *  called **soak_checkpoints.json**.
+ *  @note The pages of a size class are found through the live objects of
+ *        the simulation, so only pages which hold at least one of them are
+ *        counted. Empty pages which are kept (e.g. reserved pages), the
+ *        spans of the mid-size tier and the objects allocated by the
+ *        benchmark itself only show up in the RSS.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+#include "rpools/allocators/BitPool.hpp"
+#include "rpools/allocators/GlobalLinkedPool.hpp"
+#include "rpools/custom_new/custom_new_delete.hpp"
+#include "rpools/custom_new/size_classes.hpp"
+#include "rpools/tools/proc_utils.hpp"
+
+using rpools::BitPool;
+using rpools::BitPoolHeader;
+using rpools::GlobalLinkedPool;
+using rpools::PoolHeaderG;
+using std::vector;
+
+namespace {
+
+/** Objects larger than this are not allocated in a pool by `custom_new`. */
+const size_t THRESHOLD = 128;
+/** Number of buckets of the page occupancy histogram. */
+const size_t BUCKETS = 10;
+
+enum class Phase { RampUp, Churn, Shift, Drain };
+
+const char* phaseName(Phase t_phase) {
+    switch (t_phase) {
+    case Phase::RampUp: return "ramp-up";
+    case Phase::Churn: return "churn";
+    case Phase::Shift: return "shift";
+    default: return "drain";
+    }
+}
+
+/** A live allocation of the simulation. */
+struct Allocation {
+    /** The tick at which the allocation is freed. */
+    uint64_t death;
+    void* ptr;
+    size_t size;
+
+    /** Used to keep the allocation that dies first at the top of the heap. */
+    bool operator <(const Allocation& other) const {
+        return death > other.death;
+    }
+};
+
+#ifdef SOAK_MALLOC
+const bool USE_POOLS = false;
+#else
+const bool USE_POOLS = true;
+#endif
+
+/**
+ *  (De)allocates memory with `custom_new`, or with `malloc` in
+ *  `bench_soak_malloc`.
+ */
+struct Allocator {
+    void* allocate(size_t t_size) {
+#ifdef SOAK_MALLOC
+        return std::malloc(t_size);
+#else
+        return custom_new(t_size, rpools::getNaturalAlignment(t_size));
+#endif
+    }
+
+    void deallocate(void* t_ptr) {
+#ifdef SOAK_MALLOC
+        std::free(t_ptr);
+#else
+        custom_delete(t_ptr);
+#endif
+    }
+};
+
+/**
+ *  Draws allocation sizes and lifetimes for the simulation.
+ */
+class Workload {
+public:
+    Workload(uint64_t t_ticks)
+        : m_engine(42),
+          m_uniform(0.0, 1.0),
+          // mostly small objects
+          m_smallMix({ 30, 25, 15, 10, 8, 6, 4, 2 }),
+          // the size mix moves towards larger objects
+          m_largeMix({ 4, 6, 8, 10, 15, 20, 20, 17 }),
+          m_maxLifetime(t_ticks) {}
+
+    size_t size(Phase t_phase) {
+        // a few allocations are served by malloc in both phases
+        if (m_uniform(m_engine) < 0.02) {
+            return THRESHOLD + 1 + m_engine() % (1024 - THRESHOLD);
+        }
+        static const size_t sizes[] = { 8, 16, 24, 32, 48, 64, 96, 128 };
+        auto& mix = t_phase == Phase::Shift ? m_largeMix : m_smallMix;
+        size_t base = sizes[mix(m_engine)];
+        // do not always hit the exact size of a class
+        return base - m_engine() % 8;
+    }
+
+    /**
+     *  @return a heavy tailed lifetime that follows a Pareto distribution
+     *          (x_m = 1000, alpha = 1.1).
+     */
+    uint64_t lifetime() {
+        double u = 1.0 - m_uniform(m_engine);
+        double lifetime = 1000.0 / std::pow(u, 1.0 / 1.1);
+        return lifetime > m_maxLifetime ? m_maxLifetime
+                                        : static_cast<uint64_t>(lifetime);
+    }
+
+private:
+    std::mt19937_64 m_engine;
+    std::uniform_real_distribution<double> m_uniform;
+    std::discrete_distribution<size_t> m_smallMix;
+    std::discrete_distribution<size_t> m_largeMix;
+    uint64_t m_maxLifetime;
+};
+
+/**
+ *  @return the number of slots of a page whose slots have `t_slot` bytes.
+ */
+size_t getSlotsPerPage(size_t t_slot) {
+    switch (t_slot) {
+    case 1:
+        return BitPool<uint8_t>().getPoolSize();
+    case 2:
+        return BitPool<uint16_t>().getPoolSize();
+    case 4:
+        return BitPool<uint32_t>().getPoolSize();
+    default: {
+        // same alignment rules as the pools of custom_new
+        size_t alignment = t_slot % alignof(max_align_t) == 0 ?
+            alignof(max_align_t) : sizeof(void*);
+        return GlobalLinkedPool(t_slot, alignment).getPoolSize();
+    }
+    }
+}
+
+/**
+ *  Records the state of the process and of the pools at a given tick.
+ */
+nlohmann::json checkpoint(uint64_t t_tick, Phase t_phase,
+                          const vector<Allocation>& t_live,
+                          bool t_usePools) {
+    nlohmann::json j;
+    size_t liveBytes = 0;
+    for (const auto& alloc : t_live) {
+        liveBytes += alloc.size;
+    }
+    j["tick"] = t_tick;
+    j["phase"] = phaseName(t_phase);
+    j["live_objects"] = t_live.size();
+    j["live_bytes"] = liveBytes;
+    j["rss_kb"] = std::stoul(getResidentSetSize());
+    if (!t_usePools) {
+        return j;
+    }
+    // slot size -> page -> occupied slots of the page
+    std::map<size_t, std::map<size_t, size_t>> pages;
+    for (const auto& alloc : t_live) {
+        if (alloc.size > THRESHOLD) {
+            continue;
+        }
+        // the slot size is at the same offset in the headers of both kinds
+        // of pages (see GlobalPools::isTiny)
+        const PoolHeaderG& header =
+            GlobalLinkedPool::getPoolHeader(alloc.ptr);
+        size_t occupied = header.sizeOfSlot <= rpools::TINY_THRESHOLD ?
+            reinterpret_cast<const BitPoolHeader&>(header).occupiedSlots :
+            header.occupiedSlots;
+        pages[header.sizeOfSlot][reinterpret_cast<size_t>(&header)] =
+            occupied;
+    }
+    size_t totalPages = 0;
+    for (const auto& cls : pages) {
+        size_t slot = cls.first;
+        size_t slotsPerPage = getSlotsPerPage(slot);
+        vector<size_t> histogram(BUCKETS, 0);
+        for (const auto& page : cls.second) {
+            size_t bucket = page.second * BUCKETS / slotsPerPage;
+            ++histogram[std::min(bucket, BUCKETS - 1)];
+        }
+        auto& jc = j["classes"][std::to_string(slot)];
+        jc["pages"] = cls.second.size();
+        jc["slots_per_page"] = slotsPerPage;
+        jc["occupancy"] = histogram;
+        totalPages += cls.second.size();
+    }
+    j["pool_pages"] = totalPages;
+    return j;
+}
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t TICKS = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    uint64_t CHECKPOINTS = argc > 2 ? std::stoull(argv[2]) : 50;
+    Allocator allocator;
+    uint64_t every = std::max<uint64_t>(TICKS / CHECKPOINTS, 1);
+    uint64_t rampEnd = TICKS / 10;
+    uint64_t churnEnd = rampEnd + TICKS * 4 / 10;
+    uint64_t shiftEnd = churnEnd + TICKS * 4 / 10;
+
+    Workload workload(TICKS);
+    // min-heap of live allocations ordered by their time of death
+    vector<Allocation> live;
+    nlohmann::json results;
+    results["ticks"] = TICKS;
+    results["allocator"] = USE_POOLS ? "pools" : "malloc";
+    uint64_t operations = 0;
+    Phase phase = Phase::RampUp;
+    for (uint64_t tick = 0; tick < shiftEnd; ++tick) {
+        phase = tick < rampEnd ? Phase::RampUp :
+            tick < churnEnd ? Phase::Churn : Phase::Shift;
+        // nothing dies while ramping up
+        while (phase != Phase::RampUp && !live.empty() &&
+               live.front().death <= tick) {
+            std::pop_heap(live.begin(), live.end());
+            allocator.deallocate(live.back().ptr);
+            live.pop_back();
+            ++operations;
+        }
+        size_t size = workload.size(phase);
+        uint64_t birth = std::max(tick, rampEnd);
+        live.push_back({ birth + workload.lifetime(),
+                         allocator.allocate(size), size });
+        std::push_heap(live.begin(), live.end());
+        ++operations;
+        if (tick % every == 0) {
+            results["checkpoints"].push_back(
+                checkpoint(tick, phase, live, USE_POOLS));
+        }
+    }
+    // drain everything in the order in which it would have died
+    phase = Phase::Drain;
+    size_t drainEvery = std::max<size_t>(live.size() / 10, 1);
+    size_t drained = 0;
+    for (; !live.empty(); ++drained) {
+        if (drained % drainEvery == 0) {
+            nlohmann::json j = checkpoint(shiftEnd, phase, live, USE_POOLS);
+            j["drained"] = drained;
+            results["checkpoints"].push_back(j);
+        }
+        std::pop_heap(live.begin(), live.end());
+        allocator.deallocate(live.back().ptr);
+        live.pop_back();
+        ++operations;
+    }
+    nlohmann::json last = checkpoint(shiftEnd, phase, live, USE_POOLS);
+    last["drained"] = drained;
+    results["checkpoints"].push_back(last);
+    results["operations"] = operations;
+    results["peak_rss_kb"] = std::stoul(getPeakResidentSetSize());
+    std::ofstream f("soak_checkpoints.json");
+    f << results.dump(4);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ *  @file bench_first_alloc.cpp
+ *  Measures the cold-start cost of an allocator: the time it takes to
+ *  perform the first `new` of the process and the cost of the first
+ *  allocation of each size (up to 128 bytes) compared to the second one.
+ *  @par
+ *  When `libcustomnew.so` is preloaded, the first `new` creates the pools of
+ *  `custom_new` and the first allocation in each size class maps and carves
+ *  a page.
+ *  @par
+ *  The first `new` allocates a single byte, which is not one of the
+ *  measured sizes, so that it does not warm up any of them. When
+ *  `custom_new` is preloaded, the sizes are allocated by calling it
+ *  directly with the alignment of their size class (8 or 16), because
+ *  `operator new` aligns e.g. 24 bytes at 16 and places them in the class
+ *  of 32 bytes, which would then not be cold anymore.
+ *  @par
+ *  Usage:
+ *  * `bench_first_alloc` prints the measurements as JSON to stdout
+ *  * `bench_first_alloc --noop` exits right away, which is used to measure
+ *  the startup overhead of the process
+ *  @see time_startup_benchmarks.py
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const size_t MAX_SIZE = 128;
+const size_t STEP = sizeof(void*);
+const size_t SIZES = MAX_SIZE / STEP;
+
+/**
+ *  @return the number of nanoseconds that passed since `t_start`.
+ */
+long long elapsed(const Clock::time_point& t_start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - t_start).count();
+}
+
+/** The mangled name of `custom_new(size_t, size_t)`. */
+const char* const CUSTOM_NEW_MANGLED = "_Z10custom_newmm";
+
+using CustomNew = void* (*)(size_t, size_t);
+
+/** `custom_new` if it is preloaded, nullptr otherwise. */
+CustomNew customNew = nullptr;
+
+/**
+ *  Allocates `t_size` bytes and records how long it took.
+ *  @param t_alignment the alignment which is passed to `custom_new` if it
+ *                     is preloaded
+ *  @note the allocation is leaked on purpose so that the second allocation
+ *        of a size cannot reuse the slot of the first one.
+ */
+long long timeNew(size_t t_size, size_t t_alignment) {
+    Clock::time_point start = Clock::now();
+    char* ptr = customNew ?
+        static_cast<char*>(customNew(t_size, t_alignment)) :
+        new char[t_size];
+    long long time = elapsed(start);
+    // make sure the allocation is not optimised away
+    ptr[0] = 1;
+    return time;
+}
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--noop") == 0) {
+        return 0;
+    }
+    // no allocation should be made before this point, so that the first
+    // `new` is the one that initialises the allocator
+    long long firstAlloc = timeNew(1, 1);
+    customNew = reinterpret_cast<CustomNew>(
+        dlsym(RTLD_DEFAULT, CUSTOM_NEW_MANGLED));
+    long long firstHit[SIZES], secondHit[SIZES];
+    for (size_t i = 0; i < SIZES; ++i) {
+        size_t size = (i + 1) * STEP;
+        // the alignment of the size class of `size` (see size_classes.hpp)
+        size_t alignment = size % 16 == 0 ? 16 : STEP;
+        firstHit[i] = timeNew(size, alignment);
+        secondHit[i] = timeNew(size, alignment);
+    }
+    // printf is used to avoid allocations while the results are not printed
+    std::printf("{\n    \"first_alloc_ns\": %lld,\n    \"sizes\": {\n",
+                firstAlloc);
+    for (size_t i = 0; i < SIZES; ++i) {
+        std::printf("        \"%zu\": { \"first_ns\": %lld, "
+                    "\"second_ns\": %lld }%s\n",
+                    (i + 1) * STEP, firstHit[i], secondHit[i],
+                    i + 1 == SIZES ? "" : ",");
+    }
+    std::printf("    }\n}\n");
+    return 0;
+}
@@ -0,0 +1,293 @@
+#ifndef __BIT_POOL_H__
+#define __BIT_POOL_H__
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "rpools/tools/LMLock.hpp"
+#include "rpools/tools/pool_utils.hpp"
+
+extern "C" {
+#include "rpools/avltree/avl_utils.h"
+}
+
+namespace rpools {
+
+/**
+ *  Every pool of a `BitPool` is allocated on a page boundary.
+ *  The `BitPoolHeader` is placed at the first byte of the page and is
+ *  followed by a bitmap which has a set bit for every free slot.
+ */
+struct BitPoolHeader {
+    /** Denotes the number of slots that are occupied. */
+    size_t occupiedSlots;
+    /** The size of a slot. It has the same offset as in `PoolHeaderG`, so
+     *  that `custom_delete` can tell the pages of the two apart. */
+    size_t sizeOfSlot;
+    /** Every word of the bitmap before `hint` has no free slots. */
+    size_t hint;
+    /** The previous and next page of the allocator. */
+    BitPoolHeader* prevPool;
+    BitPoolHeader* nextPool;
+};
+
+/**
+ *  Represents a pool allocator which keeps track of the free slots of a
+ *  page with a bitmap instead of a free list.
+ *  @par
+ *  Like `LinkedPool`, the header of a page is found by masking a pointer.
+ *  A free slot is found by scanning the words of the bitmap (4 words at a
+ *  time with AVX2, when it is enabled) and counting the trailing zeros of
+ *  the first word which is not 0. Since the free slots are not linked,
+ *  freed objects are never written to, and objects can be as small as a
+ *  byte.
+ *  @note When all objects of a page are deallocated, the page is freed.
+ *  @tparam T the type of object to store in the pool
+ */
+template<typename T>
+class BitPool {
+public:
+
+    /**
+     *  Creates a `BitPool` allocator that will allocate objects of type T
+     *  in pools and return pointers to them.
+     */
+    BitPool();
+
+    BitPool(const BitPool& other) = delete;
+    BitPool& operator =(const BitPool& other) = delete;
+
+    /**
+     *  Frees every page, even if it has objects.
+     */
+    ~BitPool();
+
+    /**
+     *  Allocates space for an object of type T in one of the free slots.
+     *  @return A pointer to the newly allocated space for T, or nullptr if
+     *          a page could not be allocated.
+     */
+    void* allocate();
+
+    /**
+     *  Deallocates the memory that is used by the object of type T whose
+     *  pointer is supplied. The memory of the object is not written to.
+     *  @param t_ptr a pointer to an object that will be deallocated
+     */
+    void deallocate(void* t_ptr);
+
+    /**
+     *  @return the number of T objects that fit in a page of memory.
+     */
+    size_t getPoolSize() const { return m_poolSize; }
+
+    /**
+     *  @return the number of pages that are currently allocated.
+     */
+    size_t getNumberOfPools() const { return m_numOfPools; }
+
+private:
+    avl_tree m_freePools;
+    LMLock m_poolLock;
+    size_t m_slotSize;
+    size_t m_poolSize = 0;
+    /** The number of words of the bitmap. */
+    size_t m_words = 0;
+    /** The offset of the first slot from the start of the page. */
+    size_t m_slotsOffset = 0;
+    BitPoolHeader* m_freePool = nullptr;
+    /** All the pages of the allocator. */
+    BitPoolHeader* m_pools = nullptr;
+    size_t m_numOfPools = 0;
+
+    static uint64_t* getBits(BitPoolHeader* t_header) {
+        return reinterpret_cast<uint64_t*>(t_header + 1);
+    }
+
+    char* getFirstSlot(BitPoolHeader* t_header) const {
+        return reinterpret_cast<char*>(t_header) + m_slotsOffset;
+    }
+
+    /**
+     *  @return the index of the first word of the bitmap, starting at
+     *          `t_from`, which has a free slot.
+     */
+    size_t findFreeWord(const uint64_t* t_bits, size_t t_from) const;
+
+    /**
+     *  Allocates a page, marks all of its slots as free and adds it to the
+     *  free pages.
+     *  @return the header of the page, or nullptr if the allocation failed.
+     */
+    BitPoolHeader* createPool();
+
+    void unlinkPool(BitPoolHeader* t_header);
+};
+
+template<typename T>
+BitPool<T>::BitPool()
+    : m_freePools(),
+      m_poolLock(),
+      m_slotSize(sizeof(T)) {
+    // make sure that slots are properly aligned
+    size_t diff = mod(m_slotSize, alignof(T));
+    if (diff != 0) {
+        m_slotSize += alignof(T) - diff;
+    }
+    // the bitmap takes space from the slots, so find the largest number of
+    // slots that fit in a page together with their bitmap
+    size_t pageSize = getPageSize();
+    m_poolSize = (pageSize - sizeof(BitPoolHeader)) / m_slotSize;
+    while (m_poolSize > 0) {
+        m_words = (m_poolSize + 63) / 64;
+        m_slotsOffset = sizeof(BitPoolHeader) + m_words * sizeof(uint64_t);
+        diff = mod(m_slotsOffset, alignof(T));
+        if (diff != 0) {
+            m_slotsOffset += alignof(T) - diff;
+        }
+        if (m_slotsOffset + m_poolSize * m_slotSize <= pageSize) {
+            break;
+        }
+        --m_poolSize;
+    }
+}
+
+template<typename T>
+BitPool<T>::~BitPool() {
+    while (m_pools) {
+        BitPoolHeader* next = m_pools->nextPool;
+        if (m_pools->occupiedSlots < m_poolSize) {
+            pool_remove(&m_freePools, m_pools);
+        }
+        freePages(m_pools);
+        m_pools = next;
+    }
+}
+
+template<typename T>
+void* BitPool<T>::allocate() {
+    m_poolLock.lock();
+    BitPoolHeader* header = m_freePool;
+    if (!header) {
+        header = static_cast<BitPoolHeader*>(pool_first(&m_freePools));
+    }
+    if (!header) {
+        header = createPool();
+        if (!header) {
+            m_poolLock.unlock();
+            return nullptr;
+        }
+    }
+    uint64_t* bits = getBits(header);
+    size_t word = findFreeWord(bits, header->hint);
+    size_t slot = word * 64 + __builtin_ctzll(bits[word]);
+    // clear the lowest set bit
+    bits[word] &= bits[word] - 1;
+    header->hint = word;
+    // if the pool becomes full, don't consider it in the list of pools
+    // that have some free slots
+    if (++header->occupiedSlots == m_poolSize) {
+        pool_remove(&m_freePools, header);
+        m_freePool = static_cast<BitPoolHeader*>(pool_first(&m_freePools));
+    } else {
+        m_freePool = header;
+    }
+    m_poolLock.unlock();
+    return getFirstSlot(header) + slot * m_slotSize;
+}
+
+template<typename T>
+void BitPool<T>::deallocate(void* t_ptr) {
+    // get the pool of t_ptr
+    auto header = reinterpret_cast<BitPoolHeader*>(
+        reinterpret_cast<size_t>(t_ptr) & getPoolMask()
+    );
+    m_poolLock.lock();
+    // the last slot was deallocated => free the page
+    if (header->occupiedSlots == 1) {
+        pool_remove(&m_freePools, header);
+        unlinkPool(header);
+        freePages(header);
+        m_freePool = static_cast<BitPoolHeader*>(pool_first(&m_freePools));
+    } else {
+        size_t slot = (static_cast<char*>(t_ptr) - getFirstSlot(header)) /
+            m_slotSize;
+        size_t word = slot / 64;
+        getBits(header)[word] |= uint64_t(1) << (slot % 64);
+        if (word < header->hint) {
+            header->hint = word;
+        }
+        if (header->occupiedSlots-- == m_poolSize) {
+            pool_insert(&m_freePools, header);
+        }
+        m_freePool = header;
+    }
+    m_poolLock.unlock();
+}
+
+template<typename T>
+size_t BitPool<T>::findFreeWord(const uint64_t* t_bits,
+                                size_t t_from) const {
+    size_t word = t_from;
+#ifdef __AVX2__
+    // skip 4 full words at a time
+    for (; word + 4 <= m_words; word += 4) {
+        __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(t_bits + word));
+        if (!_mm256_testz_si256(v, v)) {
+            break;
+        }
+    }
+#endif
+    while (!t_bits[word]) {
+        ++word;
+    }
+    return word;
+}
+
+template<typename T>
+BitPoolHeader* BitPool<T>::createPool() {
+    void* page = allocatePages(1);
+    if (!page) {
+        return nullptr;
+    }
+    auto header = new (page) BitPoolHeader();
+    header->sizeOfSlot = m_slotSize;
+    uint64_t* bits = getBits(header);
+    for (size_t w = 0; w < m_words; ++w) {
+        bits[w] = ~uint64_t(0);
+    }
+    // the bits after the last slot are never free
+    if (m_poolSize % 64 != 0) {
+        bits[m_words - 1] = (uint64_t(1) << (m_poolSize % 64)) - 1;
+    }
+    header->nextPool = m_pools;
+    if (m_pools) {
+        m_pools->prevPool = header;
+    }
+    m_pools = header;
+    ++m_numOfPools;
+    pool_insert(&m_freePools, header);
+    return header;
+}
+
+template<typename T>
+void BitPool<T>::unlinkPool(BitPoolHeader* t_header) {
+    if (t_header->prevPool) {
+        t_header->prevPool->nextPool = t_header->nextPool;
+    } else {
+        m_pools = t_header->nextPool;
+    }
+    if (t_header->nextPool) {
+        t_header->nextPool->prevPool = t_header->prevPool;
+    }
+    --m_numOfPools;
+}
+
+}
+#endif // __BIT_POOL_H__
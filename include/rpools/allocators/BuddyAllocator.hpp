@@ -0,0 +1,128 @@
+#ifndef __BUDDY_ALLOCATOR_H__
+#define __BUDDY_ALLOCATOR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rpools/tools/pool_utils.hpp"
+
+namespace rpools {
+
+/**
+ *  Represents a binary buddy allocator which allocates blocks whose sizes
+ *  are powers of 2 from a page aligned region.
+ *  @par
+ *  The region is a single block of the largest order. A block of order `k`
+ *  is `getMinBlockSize() << k` bytes and is split into two buddies of order
+ *  `k - 1` when a smaller block is needed. When a block is deallocated it is
+ *  merged with its buddy (and so on) as long as the buddy is free, so both
+ *  allocation and deallocation take O(log n) time.
+ *  @par
+ *  Each order has a free list, which is kept inside of the free blocks, and
+ *  a bitmap which tells which blocks of the order are free, so that the
+ *  buddy of a block is checked in constant time.
+ *  @note `BuddyAllocator` is not thread-safe.
+ */
+class BuddyAllocator {
+public:
+    /** The default size of the region (in bytes). */
+    static const size_t DEFAULT_REGION_SIZE = 64 * 1024 * 1024;
+
+    /**
+     *  Creates a `BuddyAllocator` and allocates its region.
+     *  @param t_regionSize the size of the region, which is rounded up to a
+     *                      power of 2
+     *  @param t_minBlockSize the size of the smallest block, which is
+     *                        rounded up to a power of 2 (default: the page
+     *                        size)
+     */
+    explicit BuddyAllocator(size_t t_regionSize=DEFAULT_REGION_SIZE,
+                            size_t t_minBlockSize=getPageSize());
+
+    BuddyAllocator(const BuddyAllocator& other) = delete;
+    BuddyAllocator& operator =(const BuddyAllocator& other) = delete;
+
+    /**
+     *  Frees the region, even if it holds blocks.
+     */
+    ~BuddyAllocator();
+
+    /**
+     *  Allocates a block of at least `t_size` bytes. The block is aligned at
+     *  its own size (at most at the page size).
+     *  @param t_size the size of the allocation
+     *  @return a pointer to the block, or nullptr if no block is large
+     *          enough.
+     */
+    void* allocate(size_t t_size);
+
+    /**
+     *  Deallocates a block which was allocated by `allocate`.
+     *  @param t_ptr the block which is freed (can be nullptr)
+     */
+    void deallocate(void* t_ptr);
+
+    /**
+     *  @param t_ptr a block returned by `allocate`
+     *  @return the size of the block.
+     */
+    size_t getBlockSize(const void* t_ptr) const;
+
+    /**
+     *  @return the size of the smallest block.
+     */
+    size_t getMinBlockSize() const { return m_minBlockSize; }
+
+    /**
+     *  @return the size of the region, which is also the largest block.
+     */
+    size_t getRegionSize() const { return m_minBlockSize << m_maxOrder; }
+
+    /**
+     *  @return the number of bytes that are not allocated.
+     */
+    size_t getFreeBytes() const { return m_freeBytes; }
+
+private:
+    /** The links of the free list, kept at the start of a free block. */
+    struct FreeBlock {
+        FreeBlock* prev;
+        FreeBlock* next;
+    };
+
+    char* m_region;
+    size_t m_minBlockSize;
+    size_t m_minBlockLog2;
+    size_t m_maxOrder;
+    size_t m_freeBytes;
+    /** The first free block of each order. */
+    std::vector<FreeBlock*> m_freeLists;
+    /** A bit for every block of every order, set when the block is free. */
+    std::vector<uint64_t> m_freeBits;
+    /** The index of the first bit of each order in `m_freeBits`. */
+    std::vector<size_t> m_bitOffsets;
+    /** The order of every allocated block, by the index of its first
+     *  smallest block. */
+    std::vector<uint8_t> m_orders;
+
+    /**
+     *  @return the index of the bit of the block of order `t_order` which
+     *          starts at `t_block`.
+     */
+    size_t getBit(const char* t_block, size_t t_order) const {
+        return m_bitOffsets[t_order] +
+            ((t_block - m_region) >> (m_minBlockLog2 + t_order));
+    }
+
+    bool isFree(const char* t_block, size_t t_order) const {
+        size_t bit = getBit(t_block, t_order);
+        return (m_freeBits[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    void pushFree(char* t_block, size_t t_order);
+    void removeFree(char* t_block, size_t t_order);
+};
+}
+
+#endif // __BUDDY_ALLOCATOR_H__
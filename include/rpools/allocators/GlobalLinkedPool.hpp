@@ -1,9 +1,15 @@
 #ifndef __GLOBAL_LINKED_POOL_H__
 #define __GLOBAL_LINKED_POOL_H__
 
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
 extern "C" {
 #include "rpools/avltree/avl_utils.h"
 }
+#include "rpools/allocators/OccupancyMap.hpp"
 #include "rpools/allocators/PoolHeaderG.hpp"
 #include "rpools/tools/LMLock.hpp"
 #include "rpools/tools/pool_utils.hpp"
@@ -20,6 +26,11 @@ using Pool = void*;
  *  @par
  *  A `GlobalLinkedPool` does not know the type of object, but will be able
  *  to allocate objects that have the same size.
+ *  @par
+ *  `destroyAll`, `forEachLive` and `compact` need to know which slots are
+ *  allocated, which is tracked in a bitmap after the header of each page
+ *  only when it is asked for, so that the pools of `custom_new` do not pay
+ *  for it.
  *  @note When all objects of a page are deallocated, the page is freed.
  */
 class GlobalLinkedPool {
@@ -32,9 +43,12 @@ public:
      *                         (default: sizeof(Node))
      *  @param t_alignment the alignment of the objects
      *                     (default: alignof(max_align_t))
+     *  @param t_trackOccupancy whether the allocated slots are tracked
+     *                          (default: false)
      */
     GlobalLinkedPool(size_t t_sizeOfObjects=sizeof(Node),
-                     size_t t_alignment=alignof(max_align_t));
+                     size_t t_alignment=alignof(max_align_t),
+                     bool t_trackOccupancy=false);
 
     /**
      *  Allocates space for an object of size N in one of the free slots
@@ -51,6 +65,61 @@ public:
      */
     void deallocate(void* t_ptr);
 
+    /**
+     *  Allocates pages up front, so that the first allocations do not have
+     *  to allocate them.
+     *  @param t_pools the number of free pages that the pool should have
+     *  @note The reserved pages are freed like the rest of the pages, once
+     *        all the objects allocated in them are deallocated.
+     */
+    void reserve(size_t t_pools);
+
+    /**
+     *  Frees every page in a single pass, without destroying the objects
+     *  that are still allocated.
+     */
+    void releaseAll();
+
+    /**
+     *  Calls `t_destroy` for every slot that is still allocated and frees
+     *  every page in a single pass.
+     *  @param t_destroy the function which destroys an object
+     *  @throw std::logic_error if the allocated slots are not tracked.
+     *  @warning `t_destroy` must not use this allocator.
+     */
+    void destroyAll(void (*t_destroy)(void*));
+
+    /**
+     *  Calls `t_func` with a pointer to every allocated slot. The pages are
+     *  visited in address order and the slots of a page in address order,
+     *  so the scan is sequential.
+     *  @param t_func a function which takes a `void*`
+     *  @throw std::logic_error if the allocated slots are not tracked.
+     *  @warning `t_func` must not use this allocator.
+     */
+    template<typename F>
+    void forEachLive(F t_func);
+
+    /**
+     *  Evacuates the sparsest pages into the fullest ones and frees them.
+     *  @par
+     *  A page is only evacuated when all of its objects fit in the free
+     *  slots of fuller pages and the remaining budget allows moving all of
+     *  them, so the compaction can be done incrementally by calling
+     *  `compact` with a small budget again and again. Pages without
+     *  objects (e.g. reserved pages) are left alone.
+     *  @param t_relocate a function which takes the old and the new address
+     *                    of an object (`void*`); it must move the object
+     *                    to the new address, fix up the pointers to it and
+     *                    destroy the old object
+     *  @param t_maxMoves the largest number of objects that are moved
+     *  @return the number of pages that were freed.
+     *  @throw std::logic_error if the allocated slots are not tracked.
+     *  @warning `t_relocate` must not throw or use this allocator.
+     */
+    template<typename F>
+    size_t compact(F t_relocate, size_t t_maxMoves=SIZE_MAX);
+
     /**
      *  @return the number of slots that fit in a page of memory.
      */
@@ -72,10 +141,61 @@ private:
     avl_tree m_freePools;
     LMLock m_poolLock;
     const size_t m_sizeOfObjects;
+    /** The bytes between the header and the first slot of a page, which
+     *  hold the bitmap (if any) and the padding of the first slot. */
     size_t m_headerPadding = 0;
     size_t m_slotSize;
     size_t m_poolSize = 0;
     Pool m_freePool = nullptr;
+    /** All the pages of the allocator. */
+    PoolHeaderG* m_pools = nullptr;
+    const bool m_trackOccupancy;
+    OccupancyMap m_occupancy;
+
+    /**
+     *  Frees every page, calling `t_destroy` for the allocated slots first
+     *  if it is not nullptr.
+     *  @note The caller must hold `m_poolLock`.
+     */
+    void releasePools(void (*t_destroy)(void*));
+
+    /**
+     *  Unlinks a page from the pages of the allocator.
+     */
+    void unlinkPool(PoolHeaderG* t_header);
+
+    /**
+     *  @return the first slot of a page.
+     */
+    char* getFirstSlot(PoolHeaderG* t_header) const {
+        return reinterpret_cast<char*>(t_header + 1) + m_headerPadding;
+    }
+
+    /**
+     *  @return the bitmap of the allocated slots of a page.
+     */
+    static uint64_t* getOccupancy(PoolHeaderG* t_header) {
+        return reinterpret_cast<uint64_t*>(t_header + 1);
+    }
+
+    /**
+     *  @return the index of a slot in its page.
+     */
+    size_t getSlotIndex(PoolHeaderG* t_header, void* t_ptr) const {
+        return m_occupancy.getSlot(static_cast<char*>(t_ptr) -
+                                   getFirstSlot(t_header));
+    }
+
+    /**
+     *  @throw std::logic_error if the allocated slots are not tracked.
+     */
+    void requireOccupancy(const char* t_caller) const;
+
+    /**
+     *  Allocates a page and adds it to the free pages.
+     *  @note The caller must hold `m_poolLock`.
+     */
+    Pool createPool();
 
     /** @see LinkedPool3::constructPoolHeader */
     void constructPoolHeader(char* t_ptr);
@@ -85,5 +205,83 @@ private:
      */
     void* nextFree(Pool t_ptr);
 };
+
+template<typename F>
+void GlobalLinkedPool::forEachLive(F t_func) {
+    requireOccupancy("forEachLive");
+    m_poolLock.lock();
+    std::vector<PoolHeaderG*> pools;
+    for (PoolHeaderG* header = m_pools; header; header = header->nextPool) {
+        pools.push_back(header);
+    }
+    std::sort(pools.begin(), pools.end());
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (i + 1 < pools.size()) {
+            __builtin_prefetch(pools[i + 1]);
+        }
+        char* first = getFirstSlot(pools[i]);
+        m_occupancy.forEach(getOccupancy(pools[i]), [&](size_t t_slot) {
+            t_func(static_cast<void*>(first + t_slot * m_slotSize));
+        });
+    }
+    m_poolLock.unlock();
+}
+
+template<typename F>
+size_t GlobalLinkedPool::compact(F t_relocate, size_t t_maxMoves) {
+    requireOccupancy("compact");
+    m_poolLock.lock();
+    std::vector<PoolHeaderG*> pools;
+    for (PoolHeaderG* header = m_pools; header; header = header->nextPool) {
+        if (header->occupiedSlots && header->occupiedSlots < m_poolSize) {
+            pools.push_back(header);
+        }
+    }
+    // the sparsest pages are evacuated into the fullest ones
+    std::sort(pools.begin(), pools.end(),
+              [](PoolHeaderG* t_l, PoolHeaderG* t_r) {
+                  return t_l->occupiedSlots < t_r->occupiedSlots;
+              });
+    size_t freeSlots = 0;
+    for (auto header : pools) {
+        freeSlots += m_poolSize - header->occupiedSlots;
+    }
+    size_t freed = 0;
+    size_t dest = pools.size();
+    for (size_t src = 0; src + 1 < dest; ++src) {
+        PoolHeaderG* source = pools[src];
+        // the source is not a destination anymore
+        freeSlots -= m_poolSize - source->occupiedSlots;
+        size_t live = source->occupiedSlots;
+        if (live > freeSlots || live > t_maxMoves) {
+            break;
+        }
+        char* first = getFirstSlot(source);
+        m_occupancy.forEach(getOccupancy(source), [&](size_t t_slot) {
+            while (!pools[dest - 1]->head.next) {
+                --dest;
+            }
+            PoolHeaderG* target = pools[dest - 1];
+            Node* to = target->head.next;
+            target->head.next = to->next;
+            OccupancyMap::set(getOccupancy(target),
+                              getSlotIndex(target, to));
+            if (++target->occupiedSlots == m_poolSize) {
+                pool_remove(&m_freePools, target);
+            }
+            t_relocate(static_cast<void*>(first + t_slot * m_slotSize),
+                       static_cast<void*>(to));
+        });
+        freeSlots -= live;
+        t_maxMoves -= live;
+        pool_remove(&m_freePools, source);
+        unlinkPool(source);
+        freePages(source);
+        ++freed;
+    }
+    m_freePool = pool_first(&m_freePools);
+    m_poolLock.unlock();
+    return freed;
+}
 }
 #endif // __GLOBAL_LINKED_POOL_H__
@@ -1,10 +1,15 @@
 #ifndef __LINKED_POOL_H__
 #define __LINKED_POOL_H__
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <new>
+#include <vector>
 
 #include "rpools/allocators/Node.hpp"
+#include "rpools/allocators/OccupancyMap.hpp"
 #include "rpools/tools/LMLock.hpp"
 #include "rpools/tools/pool_utils.hpp"
 
@@ -19,7 +24,8 @@ using Pool = void*;
 /**
  *  Every pool is allocated on a page boundary.
  *  The `PoolHeader` is placed at the first byte of the page and
- *  contains certain metadata about a pool.
+ *  contains certain metadata about a pool. It is followed by the bitmap of
+ *  the allocated slots (@see OccupancyMap).
  */
 struct PoolHeader {
     /** Denotes the number of slots that are occupied. */
@@ -27,6 +33,9 @@ struct PoolHeader {
     /** A `Node` which points to the next free slot of the pool, or
      *  to nullptr if there are no slots left. */
     Node head;
+    /** The previous and next page of the allocator. */
+    PoolHeader* prevPool;
+    PoolHeader* nextPool;
 };
 
 /**
@@ -62,6 +71,48 @@ public:
      */
     void deallocate(void* t_ptr);
 
+    /**
+     *  Frees every page in a single pass, without calling the destructors
+     *  of the objects that are still allocated.
+     */
+    void releaseAll();
+
+    /**
+     *  Calls the destructor of every object that is still allocated and
+     *  frees every page in a single pass.
+     *  @warning the destructors must not use this allocator.
+     */
+    void destroyAll();
+
+    /**
+     *  Calls `t_func` with a pointer to every allocated slot. The pages are
+     *  visited in address order and the slots of a page in address order,
+     *  so the scan is sequential.
+     *  @param t_func a function which takes a `T*`
+     *  @warning `t_func` must not use this allocator.
+     */
+    template<typename F>
+    void forEachLive(F t_func);
+
+    /**
+     *  Evacuates the sparsest pages into the fullest ones and frees them.
+     *  @par
+     *  A page is only evacuated when all of its objects fit in the free
+     *  slots of fuller pages and the remaining budget allows moving all of
+     *  them, so the compaction can be done incrementally by calling
+     *  `compact` with a small budget again and again. Pages without
+     *  objects (e.g. reserved pages) are left alone.
+     *  @param t_relocate a function which takes the old and the new address
+     *                    of an object (`T*`); it must move the object
+     *                    to the new address, fix up the pointers to it and
+     *                    destroy the old object
+     *  @param t_maxMoves the largest number of objects that are moved
+     *  @return the number of pages that were freed.
+     *  @warning `t_relocate` must not throw or use this allocator.
+     */
+    template<typename F>
+    size_t compact(F t_relocate, size_t t_maxMoves=SIZE_MAX);
+
     /**
      *  @return the number of T objects that fit in a page of memory.
      */
@@ -76,10 +127,48 @@ public:
 private:
     avl_tree m_freePools;
     LMLock m_poolLock;
+    /** The bytes between the header and the first slot of a page, which
+     *  hold the bitmap and the padding of the first slot. */
     size_t m_headerPadding = 0;
     size_t m_slotSize;
     size_t m_poolSize = 0;
     Pool m_freePool = nullptr;
+    /** All the pages of the allocator. */
+    PoolHeader* m_pools = nullptr;
+    OccupancyMap m_occupancy;
+
+    /**
+     *  Frees every page, calling the destructors of the allocated objects
+     *  first if `t_destroy` is true.
+     */
+    void releasePools(bool t_destroy);
+
+    /**
+     *  Unlinks a page from the pages of the allocator.
+     */
+    void unlinkPool(PoolHeader* t_header);
+
+    /**
+     *  @return the first slot of a page.
+     */
+    char* getFirstSlot(PoolHeader* t_header) {
+        return reinterpret_cast<char*>(t_header + 1) + m_headerPadding;
+    }
+
+    /**
+     *  @return the bitmap of the allocated slots of a page.
+     */
+    static uint64_t* getOccupancy(PoolHeader* t_header) {
+        return reinterpret_cast<uint64_t*>(t_header + 1);
+    }
+
+    /**
+     *  @return the index of a slot in its page.
+     */
+    size_t getSlotIndex(PoolHeader* t_header, void* t_ptr) {
+        return m_occupancy.getSlot(static_cast<char*>(t_ptr) -
+                                   getFirstSlot(t_header));
+    }
 
     /**
      *  Creates a `PoolHeader` at **t_ptr**
@@ -98,17 +187,28 @@ LinkedPool<T>::LinkedPool()
     : m_freePools(),
       m_poolLock(),
       m_slotSize(sizeof(T) < sizeof(Node) ? sizeof(Node) : sizeof(T)) {
-    // make sure the first slot starts at a proper alignment
-    size_t diff = mod(sizeof(PoolHeader), alignof(T));
-    if (diff != 0) {
-        m_headerPadding += alignof(T) - diff;
-    }
     // make sure that slots are properly aligned
-    diff = mod(m_slotSize, alignof(T));
+    size_t diff = mod(m_slotSize, alignof(T));
     if (diff != 0) {
         m_slotSize += alignof(T) - diff;
     }
-    m_poolSize = (getPageSize() - sizeof(PoolHeader)) / m_slotSize;
+    size_t pageSize = getPageSize();
+    m_poolSize = (pageSize - sizeof(PoolHeader)) / m_slotSize;
+    // the bitmap of the page takes the space of some slots
+    for (;; --m_poolSize) {
+        m_headerPadding = OccupancyMap::getWords(m_poolSize) *
+            sizeof(uint64_t);
+        // make sure the first slot starts at a proper alignment
+        diff = mod(sizeof(PoolHeader) + m_headerPadding, alignof(T));
+        if (diff != 0) {
+            m_headerPadding += alignof(T) - diff;
+        }
+        if (sizeof(PoolHeader) + m_headerPadding + m_poolSize * m_slotSize <=
+            pageSize) {
+            break;
+        }
+    }
+    m_occupancy = OccupancyMap(m_slotSize, m_poolSize);
 }
 
 template<typename T>
@@ -126,7 +226,7 @@ void* LinkedPool<T>::allocate() {
         } else {
             // allocate a new page of memory because there are no free pool
             // slots left
-            Pool pool = aligned_alloc(getPageSize(), getPageSize());
+            Pool pool = allocatePages(1);
             constructPoolHeader(pool);
             pool_insert(&m_freePools, pool);
             m_freePool = pool;
@@ -145,7 +245,8 @@ void LinkedPool<T>::deallocate(void* t_ptr) {
     // the last slot was deallocated => free the page
     if (pool->occupiedSlots == 1) {
         pool_remove(&m_freePools, pool);
-        free(pool);
+        unlinkPool(pool);
+        freePages(pool);
         m_freePool = pool_first(&m_freePools);
     } else {
         auto newNodeG = new (t_ptr) Node();
@@ -153,6 +254,7 @@ void LinkedPool<T>::deallocate(void* t_ptr) {
         Node& head = pool->head;
         newNodeG->next = head.next;
         head.next = newNodeG;
+        OccupancyMap::reset(getOccupancy(pool), getSlotIndex(pool, t_ptr));
         m_freePool = pool;
         // the pool is not full, therefore add it to the list of pools
         // that have free slots
@@ -163,9 +265,139 @@ void LinkedPool<T>::deallocate(void* t_ptr) {
     m_poolLock.unlock();
 }
 
+template<typename T>
+void LinkedPool<T>::releaseAll() {
+    m_poolLock.lock();
+    releasePools(false);
+    m_poolLock.unlock();
+}
+
+template<typename T>
+void LinkedPool<T>::destroyAll() {
+    m_poolLock.lock();
+    releasePools(true);
+    m_poolLock.unlock();
+}
+
+template<typename T>
+void LinkedPool<T>::releasePools(bool t_destroy) {
+    while (m_pools) {
+        PoolHeader* header = m_pools;
+        m_pools = header->nextPool;
+        if (t_destroy) {
+            char* first = getFirstSlot(header);
+            m_occupancy.forEach(getOccupancy(header), [&](size_t t_slot) {
+                reinterpret_cast<T*>(first + t_slot * m_slotSize)->~T();
+            });
+        }
+        if (header->occupiedSlots < m_poolSize) {
+            pool_remove(&m_freePools, header);
+        }
+        freePages(header);
+    }
+    m_freePool = nullptr;
+}
+
+template<typename T>
+template<typename F>
+void LinkedPool<T>::forEachLive(F t_func) {
+    m_poolLock.lock();
+    std::vector<PoolHeader*> pools;
+    for (PoolHeader* header = m_pools; header; header = header->nextPool) {
+        pools.push_back(header);
+    }
+    std::sort(pools.begin(), pools.end());
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (i + 1 < pools.size()) {
+            __builtin_prefetch(pools[i + 1]);
+        }
+        char* first = getFirstSlot(pools[i]);
+        m_occupancy.forEach(getOccupancy(pools[i]), [&](size_t t_slot) {
+            t_func(reinterpret_cast<T*>(first + t_slot * m_slotSize));
+        });
+    }
+    m_poolLock.unlock();
+}
+
+template<typename T>
+template<typename F>
+size_t LinkedPool<T>::compact(F t_relocate, size_t t_maxMoves) {
+    m_poolLock.lock();
+    std::vector<PoolHeader*> pools;
+    for (PoolHeader* header = m_pools; header; header = header->nextPool) {
+        if (header->occupiedSlots && header->occupiedSlots < m_poolSize) {
+            pools.push_back(header);
+        }
+    }
+    // the sparsest pages are evacuated into the fullest ones
+    std::sort(pools.begin(), pools.end(),
+              [](PoolHeader* t_l, PoolHeader* t_r) {
+                  return t_l->occupiedSlots < t_r->occupiedSlots;
+              });
+    size_t freeSlots = 0;
+    for (auto header : pools) {
+        freeSlots += m_poolSize - header->occupiedSlots;
+    }
+    size_t freed = 0;
+    size_t dest = pools.size();
+    for (size_t src = 0; src + 1 < dest; ++src) {
+        PoolHeader* source = pools[src];
+        // the source is not a destination anymore
+        freeSlots -= m_poolSize - source->occupiedSlots;
+        size_t live = source->occupiedSlots;
+        if (live > freeSlots || live > t_maxMoves) {
+            break;
+        }
+        char* first = getFirstSlot(source);
+        m_occupancy.forEach(getOccupancy(source), [&](size_t t_slot) {
+            while (!pools[dest - 1]->head.next) {
+                --dest;
+            }
+            PoolHeader* target = pools[dest - 1];
+            Node* to = target->head.next;
+            target->head.next = to->next;
+            OccupancyMap::set(getOccupancy(target),
+                              getSlotIndex(target, to));
+            if (++target->occupiedSlots == m_poolSize) {
+                pool_remove(&m_freePools, target);
+            }
+            t_relocate(reinterpret_cast<T*>(first + t_slot * m_slotSize),
+                       reinterpret_cast<T*>(to));
+        });
+        freeSlots -= live;
+        t_maxMoves -= live;
+        pool_remove(&m_freePools, source);
+        unlinkPool(source);
+        freePages(source);
+        ++freed;
+    }
+    m_freePool = pool_first(&m_freePools);
+    m_poolLock.unlock();
+    return freed;
+}
+
+template<typename T>
+void LinkedPool<T>::unlinkPool(PoolHeader* t_header) {
+    if (t_header->prevPool) {
+        t_header->prevPool->nextPool = t_header->nextPool;
+    } else {
+        m_pools = t_header->nextPool;
+    }
+    if (t_header->nextPool) {
+        t_header->nextPool->prevPool = t_header->prevPool;
+    }
+}
+
 template<typename T>
 void LinkedPool<T>::constructPoolHeader(Pool t_ptr) {
     auto header = new (t_ptr) PoolHeader();
+    std::memset(getOccupancy(header), 0, m_occupancy.getSize());
+    header->prevPool = nullptr;
+    header->nextPool = m_pools;
+    if (m_pools) {
+        m_pools->prevPool = header;
+    }
+    m_pools = header;
     auto first = reinterpret_cast<char*>(header + 1);
     first += m_headerPadding;
     header->head.next = reinterpret_cast<Node*>(first);
@@ -184,6 +416,8 @@ void* LinkedPool<T>::nextFree(Pool t_ptr) {
     void* toReturn = head.next;
     if (head.next) {
         head.next = head.next->next;
+        OccupancyMap::set(getOccupancy(header),
+                          getSlotIndex(header, toReturn));
         // if the pool becomes full, don't consider it in the list
         // of pools that have some free slots
         if (++(header->occupiedSlots) == m_poolSize) {
@@ -0,0 +1,202 @@
+#ifndef __LOCK_FREE_MEMORY_POOL_H__
+#define __LOCK_FREE_MEMORY_POOL_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "rpools/tools/LMLock.hpp"
+
+namespace rpools {
+
+/**
+ *  Represents a variant of `MemoryPool` whose free slots are kept in a
+ *  lock-free stack (a Treiber stack), so that threads which allocate and
+ *  deallocate at the same time do not wait for each other.
+ *  @par
+ *  The head of the stack is a pointer with a counter in its upper 16 bits
+ *  (user space addresses fit in 48 bits), which is incremented by every
+ *  pop. If the head is popped and pushed back while the pop of another
+ *  thread is delayed, the counter makes the compare-and-swap of that thread
+ *  fail (the ABA problem).
+ *  @par
+ *  Only the allocation of a block takes a lock: the slots of a new block
+ *  are pushed to the stack as a single chain.
+ *  @note A thread whose pop fails might still read a slot which was popped
+ *        by another thread, so blocks are only freed when the pool is
+ *        destroyed.
+ *  @tparam T the type of object to store in the pool
+ *  @tparam BlockSize the number of bytes of a block, a multiple of the
+ *                   alignment of T
+ */
+template<typename T, size_t BlockSize = 4096>
+class LockFreeMemoryPool {
+public:
+    LockFreeMemoryPool() : m_head(0), m_blockLock(), m_numOfBlocks(0) {}
+    LockFreeMemoryPool(const LockFreeMemoryPool& other) = delete;
+    LockFreeMemoryPool& operator =(const LockFreeMemoryPool& other) = delete;
+
+    /**
+     *  Frees every block, without destroying the objects.
+     */
+    ~LockFreeMemoryPool();
+
+    /**
+     *  Allocates space for an object of type T.
+     *  @return a pointer to the allocated space.
+     *  @throw std::bad_alloc if a block could not be allocated.
+     */
+    T* allocate();
+
+    /**
+     *  Deallocates the memory of the object whose pointer is supplied.
+     *  @param t_ptr a pointer which was returned by `allocate`
+     */
+    void deallocate(T* t_ptr) {
+        if (t_ptr) {
+            Slot* slot = reinterpret_cast<Slot*>(t_ptr);
+            push(slot, slot);
+        }
+    }
+
+    /**
+     *  @return the number of blocks that are allocated.
+     */
+    size_t getNumberOfBlocks() const {
+        return m_numOfBlocks.load(std::memory_order_relaxed);
+    }
+
+private:
+    union Slot {
+        T element;
+        Slot* next;
+    };
+
+    static const unsigned TAG_SHIFT = 48;
+    /**
+     *  The alignment of a block, which is enough for both the pointer to
+     *  the next block and the slots, even if T is over-aligned.
+     */
+    static const size_t BLOCK_ALIGNMENT = alignof(Slot) > alignof(void*) ?
+        alignof(Slot) : alignof(void*);
+    static const uint64_t POINTER_MASK = (uint64_t(1) << TAG_SHIFT) - 1;
+    /** The offset of the first slot, after the pointer to the next block. */
+    static const size_t SLOTS_OFFSET =
+        (sizeof(void*) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+    static const size_t SLOTS_PER_BLOCK =
+        (BlockSize - SLOTS_OFFSET) / sizeof(Slot);
+
+    static_assert(sizeof(void*) == sizeof(uint64_t),
+                  "the head packs a pointer and a counter in 64 bits");
+    static_assert(SLOTS_PER_BLOCK >= 2, "BlockSize too small.");
+    static_assert(BlockSize % BLOCK_ALIGNMENT == 0,
+                  "aligned_alloc needs a multiple of the alignment.");
+
+    /** The head of the stack of free slots and its counter. */
+    std::atomic<uint64_t> m_head;
+    /** Taken while a block is allocated. */
+    LMLock m_blockLock;
+    /** All the blocks, linked through their first word. */
+    void* m_blocks = nullptr;
+    std::atomic<size_t> m_numOfBlocks;
+
+    static Slot* getSlot(uint64_t t_head) {
+        return reinterpret_cast<Slot*>(t_head & POINTER_MASK);
+    }
+
+    static uint64_t getTag(uint64_t t_head) {
+        return t_head >> TAG_SHIFT;
+    }
+
+    static uint64_t makeHead(Slot* t_slot, uint64_t t_tag) {
+        return reinterpret_cast<uint64_t>(t_slot) | (t_tag << TAG_SHIFT);
+    }
+
+    /**
+     *  Pushes the chain of slots from `t_first` to `t_last` to the stack.
+     */
+    void push(Slot* t_first, Slot* t_last);
+
+    /**
+     *  Allocates a block, pushes all of its slots but the first to the stack
+     *  and returns the first one.
+     *  @return nullptr if another thread filled the stack while the calling
+     *          thread waited for the lock.
+     */
+    T* allocateBlock();
+};
+
+template<typename T, size_t BlockSize>
+LockFreeMemoryPool<T, BlockSize>::~LockFreeMemoryPool() {
+    while (m_blocks) {
+        void* next = *static_cast<void**>(m_blocks);
+        std::free(m_blocks);
+        m_blocks = next;
+    }
+}
+
+template<typename T, size_t BlockSize>
+T* LockFreeMemoryPool<T, BlockSize>::allocate() {
+    for (;;) {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        while (Slot* slot = getSlot(head)) {
+            // the slot might be popped and reused by another thread, in
+            // which case the counter has changed and the CAS fails
+            Slot* next = __atomic_load_n(&slot->next, __ATOMIC_RELAXED);
+            if (m_head.compare_exchange_weak(
+                    head, makeHead(next, getTag(head) + 1),
+                    std::memory_order_acquire, std::memory_order_acquire)) {
+                return reinterpret_cast<T*>(slot);
+            }
+        }
+        T* ptr = allocateBlock();
+        if (ptr) {
+            return ptr;
+        }
+    }
+}
+
+template<typename T, size_t BlockSize>
+void LockFreeMemoryPool<T, BlockSize>::push(Slot* t_first, Slot* t_last) {
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    do {
+        __atomic_store_n(&t_last->next, getSlot(head), __ATOMIC_RELAXED);
+    } while (!m_head.compare_exchange_weak(head,
+                                           makeHead(t_first, getTag(head)),
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+template<typename T, size_t BlockSize>
+T* LockFreeMemoryPool<T, BlockSize>::allocateBlock() {
+    m_blockLock.lock();
+    // another thread might have pushed a block while we were waiting
+    if (getSlot(m_head.load(std::memory_order_acquire))) {
+        m_blockLock.unlock();
+        return nullptr;
+    }
+    // operator new only aligns at alignof(max_align_t)
+    char* block = static_cast<char*>(aligned_alloc(BLOCK_ALIGNMENT,
+                                                   BlockSize));
+    if (!block) {
+        m_blockLock.unlock();
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<void**>(block) = m_blocks;
+    m_blocks = block;
+    m_numOfBlocks.fetch_add(1, std::memory_order_relaxed);
+    // the chain is private until it is pushed, which is done before the
+    // lock is released so that waiting threads find the slots
+    Slot* slots = reinterpret_cast<Slot*>(block + SLOTS_OFFSET);
+    for (size_t i = 1; i + 1 < SLOTS_PER_BLOCK; ++i) {
+        slots[i].next = &slots[i + 1];
+    }
+    push(&slots[1], &slots[SLOTS_PER_BLOCK - 1]);
+    m_blockLock.unlock();
+    return reinterpret_cast<T*>(&slots[0]);
+}
+
+}
+#endif // __LOCK_FREE_MEMORY_POOL_H__
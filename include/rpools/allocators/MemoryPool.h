@@ -23,8 +23,12 @@
 #ifndef MEMORY_POOL_H
 #define MEMORY_POOL_H
 
+#include <algorithm>
 #include <climits>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <vector>
 
 #ifdef __x86_64
@@ -34,7 +38,12 @@
 #include <thread>
 #endif
 
-template <typename T>
+// Blocks are aligned at BlockSize, so the block of a slot is found by
+// masking its address. Every block counts its live elements and keeps its
+// own free list; a block is freed as soon as its last element is
+// deallocated, except for a single spare block which is kept to absorb
+// bursts that allocate and free around a block boundary.
+template <typename T, size_t BlockSize = 4096>
 class MemoryPool
 {
   public:
@@ -51,14 +60,15 @@ class MemoryPool
     typedef std::true_type  propagate_on_container_swap;
 
     template <typename U> struct rebind {
-      typedef MemoryPool<U> other;
+      typedef MemoryPool<U, BlockSize> other;
     };
 
     /* Member functions */
     MemoryPool() noexcept;
     MemoryPool(const MemoryPool& memoryPool) noexcept;
     MemoryPool(MemoryPool&& memoryPool) noexcept;
-    template <class U> MemoryPool(const MemoryPool<U>& memoryPool) noexcept;
+    template <class U>
+    MemoryPool(const MemoryPool<U, BlockSize>& memoryPool) noexcept;
 
     ~MemoryPool() noexcept;
 
@@ -80,12 +90,33 @@ class MemoryPool
     template <class... Args> pointer newElement(Args&&... args);
     void deleteElement(pointer p);
 
+    // Frees every block in a single pass, without destroying the elements
+    void releaseAll();
+    // Destroys every element that is still allocated and frees every block.
+    // The destructors must not use this pool.
+    void destroyAll();
+
+    // The number of blocks that hold elements or are being carved
+    size_type getNumberOfBlocks() const noexcept { return numOfBlocks_; }
+
   private:
     union Slot_ {
       value_type element;
       Slot_* next;
     };
 
+    // Placed at the start of every block
+    struct Block_ {
+      // All the blocks of the pool
+      Block_* prev;
+      Block_* next;
+      // The blocks whose free list is not empty
+      Block_* prevFree;
+      Block_* nextFree;
+      Slot_* freeSlots;
+      size_t live;
+    };
+
 #ifdef __x86_64
     light_lock_t m_lock;
 #else
@@ -95,29 +126,60 @@ class MemoryPool
     typedef char* data_pointer_;
     typedef Slot_ slot_type_;
     typedef Slot_* slot_pointer_;
+    typedef Block_* block_pointer_;
 
-    slot_pointer_ currentBlock_;
+    block_pointer_ currentBlock_;
     slot_pointer_ currentSlot_;
     slot_pointer_ lastSlot_;
-    slot_pointer_ freeSlots_;
+    block_pointer_ blocks_;
+    block_pointer_ freeBlocks_;
+    block_pointer_ spareBlock_;
+    size_type numOfBlocks_;
 
     size_type padPointer(data_pointer_ p, size_type align) const noexcept;
+    static block_pointer_ getBlock(void* p) noexcept;
+    slot_pointer_ getFirstSlot(block_pointer_ block) const noexcept;
     void allocateBlock();
-
-    static_assert(4096 >= 2 * sizeof(slot_type_), "BlockSize too small.");
+    void releaseBlock(block_pointer_ block);
+    void unlinkFree(block_pointer_ block) noexcept;
+    void releaseBlocks(bool destroy);
+
+    static_assert((BlockSize & (BlockSize - 1)) == 0,
+                  "BlockSize must be a power of 2.");
+    static_assert(BlockSize >= sizeof(Block_) + alignof(slot_type_) +
+                  2 * sizeof(slot_type_), "BlockSize too small.");
 };
 
-template <typename T>
-inline typename MemoryPool<T>::size_type
-MemoryPool<T>::padPointer(data_pointer_ p, size_type align)
+template <typename T, size_t BlockSize>
+inline typename MemoryPool<T, BlockSize>::size_type
+MemoryPool<T, BlockSize>::padPointer(data_pointer_ p, size_type align)
 const noexcept
 {
   uintptr_t result = reinterpret_cast<uintptr_t>(p);
   return ((align - result) % align);
 }
 
-template <typename T>
-MemoryPool<T>::MemoryPool() noexcept
+template <typename T, size_t BlockSize>
+inline typename MemoryPool<T, BlockSize>::block_pointer_
+MemoryPool<T, BlockSize>::getBlock(void* p)
+noexcept
+{
+  return reinterpret_cast<block_pointer_>(
+      reinterpret_cast<uintptr_t>(p) & ~uintptr_t(BlockSize - 1));
+}
+
+template <typename T, size_t BlockSize>
+inline typename MemoryPool<T, BlockSize>::slot_pointer_
+MemoryPool<T, BlockSize>::getFirstSlot(block_pointer_ block)
+const noexcept
+{
+  data_pointer_ body = reinterpret_cast<data_pointer_>(block + 1);
+  return reinterpret_cast<slot_pointer_>
+         (body + padPointer(body, alignof(slot_type_)));
+}
+
+template <typename T, size_t BlockSize>
+MemoryPool<T, BlockSize>::MemoryPool() noexcept
     : m_lock(
 #ifdef __x86_64
           LIGHT_LOCK_INIT
@@ -126,73 +188,88 @@ MemoryPool<T>::MemoryPool() noexcept
       currentBlock_(nullptr),
       currentSlot_(nullptr),
       lastSlot_(nullptr),
-      freeSlots_ (nullptr) {
+      blocks_(nullptr),
+      freeBlocks_(nullptr),
+      spareBlock_(nullptr),
+      numOfBlocks_(0) {
 }
 
-template <typename T>
-MemoryPool<T>::MemoryPool(const MemoryPool& memoryPool)
+template <typename T, size_t BlockSize>
+MemoryPool<T, BlockSize>::MemoryPool(const MemoryPool& memoryPool)
 noexcept :
 MemoryPool()
 {}
 
 
 
-template <typename T>
-MemoryPool<T>::MemoryPool(MemoryPool&& memoryPool)
+template <typename T, size_t BlockSize>
+MemoryPool<T, BlockSize>::MemoryPool(MemoryPool&& memoryPool)
 noexcept
     : m_lock(std::move(memoryPool.m_lock)),
-      currentBlock_(std::move(memoryPool.currentBlock_)),
-      currentSlot_(std::move(memoryPool.currentSlot_)),
-      lastSlot_(std::move(memoryPool.lastSlot_)),
-      freeSlots_(memoryPool.freeSlots_) {
+      currentBlock_(memoryPool.currentBlock_),
+      currentSlot_(memoryPool.currentSlot_),
+      lastSlot_(memoryPool.lastSlot_),
+      blocks_(memoryPool.blocks_),
+      freeBlocks_(memoryPool.freeBlocks_),
+      spareBlock_(memoryPool.spareBlock_),
+      numOfBlocks_(memoryPool.numOfBlocks_) {
   memoryPool.currentBlock_ = nullptr;
+  memoryPool.currentSlot_ = nullptr;
+  memoryPool.lastSlot_ = nullptr;
+  memoryPool.blocks_ = nullptr;
+  memoryPool.freeBlocks_ = nullptr;
+  memoryPool.spareBlock_ = nullptr;
+  memoryPool.numOfBlocks_ = 0;
 }
 
 
-template <typename T>
+template <typename T, size_t BlockSize>
 template<class U>
-MemoryPool<T>::MemoryPool(const MemoryPool<U>& memoryPool)
+MemoryPool<T, BlockSize>::MemoryPool(const MemoryPool<U, BlockSize>& memoryPool)
 noexcept :
 MemoryPool()
 {}
 
 
 
-template <typename T>
-MemoryPool<T>&
-MemoryPool<T>::operator=(MemoryPool&& memoryPool)
+template <typename T, size_t BlockSize>
+MemoryPool<T, BlockSize>&
+MemoryPool<T, BlockSize>::operator=(MemoryPool&& memoryPool)
 noexcept
 {
   if (this != &memoryPool)
   {
-    m_lock = memoryPool.m_lock;
     std::swap(currentBlock_, memoryPool.currentBlock_);
-    currentSlot_ = memoryPool.currentSlot_;
-    lastSlot_ = memoryPool.lastSlot_;
-    freeSlots_ = memoryPool.freeSlots;
+    std::swap(currentSlot_, memoryPool.currentSlot_);
+    std::swap(lastSlot_, memoryPool.lastSlot_);
+    std::swap(blocks_, memoryPool.blocks_);
+    std::swap(freeBlocks_, memoryPool.freeBlocks_);
+    std::swap(spareBlock_, memoryPool.spareBlock_);
+    std::swap(numOfBlocks_, memoryPool.numOfBlocks_);
   }
   return *this;
 }
 
 
 
-template <typename T>
-MemoryPool<T>::~MemoryPool()
+template <typename T, size_t BlockSize>
+MemoryPool<T, BlockSize>::~MemoryPool()
 noexcept
 {
-  slot_pointer_ curr = currentBlock_;
+  block_pointer_ curr = blocks_;
   while (curr != nullptr) {
-    slot_pointer_ prev = curr->next;
-    operator delete(reinterpret_cast<void*>(curr));
-    curr = prev;
+    block_pointer_ next = curr->next;
+    std::free(curr);
+    curr = next;
   }
+  std::free(spareBlock_);
 }
 
 
 
-template <typename T>
-inline typename MemoryPool<T>::pointer
-MemoryPool<T>::address(reference x)
+template <typename T, size_t BlockSize>
+inline typename MemoryPool<T, BlockSize>::pointer
+MemoryPool<T, BlockSize>::address(reference x)
 const noexcept
 {
   return &x;
@@ -200,9 +277,9 @@ const noexcept
 
 
 
-template <typename T>
-inline typename MemoryPool<T>::const_pointer
-MemoryPool<T>::address(const_reference x)
+template <typename T, size_t BlockSize>
+inline typename MemoryPool<T, BlockSize>::const_pointer
+MemoryPool<T, BlockSize>::address(const_reference x)
 const noexcept
 {
   return &x;
@@ -210,43 +287,110 @@ const noexcept
 
 
 
-template <typename T>
+template <typename T, size_t BlockSize>
 void
-MemoryPool<T>::allocateBlock()
+MemoryPool<T, BlockSize>::allocateBlock()
 {
-
-  // Allocate space for the new block and store a pointer to the previous one
-  data_pointer_ newBlock = reinterpret_cast<data_pointer_>(operator new(4096));
-  reinterpret_cast<slot_pointer_>(newBlock)->next = currentBlock_;
-  currentBlock_ = reinterpret_cast<slot_pointer_>(newBlock);
-  // Pad block body to staisfy the alignment requirements for elements
-  data_pointer_ body = newBlock + sizeof(slot_pointer_);
-  size_type bodyPadding = padPointer(body, alignof(slot_type_));
-  currentSlot_ = reinterpret_cast<slot_pointer_>(body + bodyPadding);
+  // Reuse the spare block if there is one
+  void* memory = spareBlock_;
+  spareBlock_ = nullptr;
+  if (memory == nullptr) {
+    memory = aligned_alloc(BlockSize, BlockSize);
+    if (memory == nullptr)
+      throw std::bad_alloc();
+  }
+  block_pointer_ newBlock = new (memory) Block_();
+  newBlock->next = blocks_;
+  if (blocks_ != nullptr)
+    blocks_->prev = newBlock;
+  blocks_ = newBlock;
+  ++numOfBlocks_;
+  currentBlock_ = newBlock;
+  currentSlot_ = getFirstSlot(newBlock);
   lastSlot_ = reinterpret_cast<slot_pointer_>
-              (newBlock + 4096 - sizeof(slot_type_) + 1);
+              (reinterpret_cast<data_pointer_>(newBlock) + BlockSize -
+               sizeof(slot_type_) + 1);
+}
+
+
+
+template <typename T, size_t BlockSize>
+void
+MemoryPool<T, BlockSize>::releaseBlock(block_pointer_ block)
+{
+  if (block->freeSlots != nullptr)
+    unlinkFree(block);
+  if (block == currentBlock_) {
+    // The block is still carved, start over instead of freeing it
+    block->freeSlots = nullptr;
+    currentSlot_ = getFirstSlot(block);
+    return;
+  }
+  if (block->prev != nullptr)
+    block->prev->next = block->next;
+  else
+    blocks_ = block->next;
+  if (block->next != nullptr)
+    block->next->prev = block->prev;
+  --numOfBlocks_;
+  if (spareBlock_ == nullptr)
+    spareBlock_ = block;
+  else
+    std::free(block);
 }
 
 
 
-template <typename T>
-inline typename MemoryPool<T>::pointer
-MemoryPool<T>::allocate(size_type n, const_pointer hint)
+template <typename T, size_t BlockSize>
+inline void
+MemoryPool<T, BlockSize>::unlinkFree(block_pointer_ block)
+noexcept
+{
+  if (block->prevFree != nullptr)
+    block->prevFree->nextFree = block->nextFree;
+  else
+    freeBlocks_ = block->nextFree;
+  if (block->nextFree != nullptr)
+    block->nextFree->prevFree = block->prevFree;
+  block->prevFree = nullptr;
+  block->nextFree = nullptr;
+}
+
+
+
+template <typename T, size_t BlockSize>
+inline typename MemoryPool<T, BlockSize>::pointer
+MemoryPool<T, BlockSize>::allocate(size_type n, const_pointer hint)
 {
 #ifdef __x86_64
   light_lock(&m_lock);
 #else
   std::lock_guard<std::mutex> lock(m_lock);
 #endif
-  MemoryPool<T>::pointer toRet = nullptr;
-  if (freeSlots_ != nullptr) {
-    pointer result = reinterpret_cast<pointer>(freeSlots_);
-    freeSlots_ = freeSlots_->next;
-    toRet = result;
+  MemoryPool<T, BlockSize>::pointer toRet = nullptr;
+  if (freeBlocks_ != nullptr) {
+    block_pointer_ block = freeBlocks_;
+    slot_pointer_ result = block->freeSlots;
+    block->freeSlots = result->next;
+    ++block->live;
+    if (block->freeSlots == nullptr)
+      unlinkFree(block);
+    toRet = reinterpret_cast<pointer>(result);
   }
   else {
-    if (currentSlot_ >= lastSlot_)
+    if (currentSlot_ >= lastSlot_) {
+#ifdef __x86_64
+      try {
+        allocateBlock();
+      } catch (...) {
+        light_unlock(&m_lock);
+        throw;
+      }
+#else
       allocateBlock();
+#endif
+    }
+    ++currentBlock_->live;
     toRet = reinterpret_cast<pointer>(currentSlot_++);
   }
 #ifdef __x86_64
@@ -257,9 +401,9 @@ MemoryPool<T>::allocate(size_type n, const_pointer hint)
 
 
 
-template <typename T>
+template <typename T, size_t BlockSize>
 inline void
-MemoryPool<T>::deallocate(pointer p, size_type n)
+MemoryPool<T, BlockSize>::deallocate(pointer p, size_type n)
 {
   if (p != nullptr) {
 #ifdef __x86_64
@@ -267,8 +411,20 @@ MemoryPool<T>::deallocate(pointer p, size_type n)
 #else
     std::lock_guard<std::mutex> lock(m_lock);
 #endif
-    reinterpret_cast<slot_pointer_>(p)->next = freeSlots_;
-    freeSlots_ = reinterpret_cast<slot_pointer_>(p);
+    block_pointer_ block = getBlock(p);
+    if (--block->live == 0) {
+      releaseBlock(block);
+    }
+    else {
+      if (block->freeSlots == nullptr) {
+        block->nextFree = freeBlocks_;
+        if (freeBlocks_ != nullptr)
+          freeBlocks_->prevFree = block;
+        freeBlocks_ = block;
+      }
+      reinterpret_cast<slot_pointer_>(p)->next = block->freeSlots;
+      block->freeSlots = reinterpret_cast<slot_pointer_>(p);
+    }
 #ifdef __x86_64
     light_unlock(&m_lock);
 #endif
@@ -277,41 +433,41 @@ MemoryPool<T>::deallocate(pointer p, size_type n)
 
 
 
-template <typename T>
-inline typename MemoryPool<T>::size_type
-MemoryPool<T>::max_size()
+template <typename T, size_t BlockSize>
+inline typename MemoryPool<T, BlockSize>::size_type
+MemoryPool<T, BlockSize>::max_size()
 const noexcept
 {
-  size_type maxBlocks = -1 / 4096;
-  return (4096 - sizeof(data_pointer_)) / sizeof(slot_type_) * maxBlocks;
+  size_type maxBlocks = -1 / BlockSize;
+  return (BlockSize - sizeof(Block_)) / sizeof(slot_type_) * maxBlocks;
 }
 
 
 
-template <typename T>
+template <typename T, size_t BlockSize>
 template <class U, class... Args>
 inline void
-MemoryPool<T>::construct(U* p, Args&&... args)
+MemoryPool<T, BlockSize>::construct(U* p, Args&&... args)
 {
   new (p) U (std::forward<Args>(args)...);
 }
 
 
 
-template <typename T>
+template <typename T, size_t BlockSize>
 template <class U>
 inline void
-MemoryPool<T>::destroy(U* p)
+MemoryPool<T, BlockSize>::destroy(U* p)
 {
   p->~U();
 }
 
 
 
-template <typename T>
+template <typename T, size_t BlockSize>
 template <class... Args>
-inline typename MemoryPool<T>::pointer
-MemoryPool<T>::newElement(Args&&... args)
+inline typename MemoryPool<T, BlockSize>::pointer
+MemoryPool<T, BlockSize>::newElement(Args&&... args)
 {
   pointer result = allocate();
   construct<value_type>(result, std::forward<Args>(args)...);
@@ -320,9 +476,9 @@ MemoryPool<T>::newElement(Args&&... args)
 
 
 
-template <typename T>
+template <typename T, size_t BlockSize>
 inline void
-MemoryPool<T>::deleteElement(pointer p)
+MemoryPool<T, BlockSize>::deleteElement(pointer p)
 {
   if (p != nullptr) {
     p->~value_type();
@@ -330,4 +486,78 @@ MemoryPool<T>::deleteElement(pointer p)
   }
 }
 
+
+
+template <typename T, size_t BlockSize>
+void
+MemoryPool<T, BlockSize>::releaseAll()
+{
+#ifdef __x86_64
+  light_lock(&m_lock);
+#else
+  std::lock_guard<std::mutex> lock(m_lock);
+#endif
+  releaseBlocks(false);
+#ifdef __x86_64
+  light_unlock(&m_lock);
+#endif
+}
+
+
+
+template <typename T, size_t BlockSize>
+void
+MemoryPool<T, BlockSize>::destroyAll()
+{
+#ifdef __x86_64
+  light_lock(&m_lock);
+#else
+  std::lock_guard<std::mutex> lock(m_lock);
+#endif
+  releaseBlocks(true);
+#ifdef __x86_64
+  light_unlock(&m_lock);
+#endif
+}
+
+
+
+template <typename T, size_t BlockSize>
+void
+MemoryPool<T, BlockSize>::releaseBlocks(bool destroy)
+{
+  std::vector<slot_pointer_> freeSlots;
+  block_pointer_ curr = blocks_;
+  while (curr != nullptr) {
+    block_pointer_ next = curr->next;
+    if (destroy) {
+      // The slots of the free list are not destroyed
+      freeSlots.clear();
+      for (slot_pointer_ slot = curr->freeSlots; slot != nullptr;
+           slot = slot->next)
+        freeSlots.push_back(slot);
+      std::sort(freeSlots.begin(), freeSlots.end());
+      // The current block is only used up to currentSlot_
+      slot_pointer_ end = curr == currentBlock_ ? currentSlot_ :
+          reinterpret_cast<slot_pointer_>
+          (reinterpret_cast<data_pointer_>(curr) + BlockSize -
+           sizeof(slot_type_) + 1);
+      for (slot_pointer_ slot = getFirstSlot(curr); slot < end; ++slot) {
+        if (!std::binary_search(freeSlots.begin(), freeSlots.end(), slot))
+          reinterpret_cast<pointer>(slot)->~value_type();
+      }
+    }
+    std::free(curr);
+    curr = next;
+  }
+  std::free(spareBlock_);
+  currentBlock_ = nullptr;
+  currentSlot_ = nullptr;
+  lastSlot_ = nullptr;
+  blocks_ = nullptr;
+  freeBlocks_ = nullptr;
+  spareBlock_ = nullptr;
+  numOfBlocks_ = 0;
+}
+
 #endif // MEMORY_POOL_H
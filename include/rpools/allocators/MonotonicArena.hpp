@@ -0,0 +1,144 @@
+#ifndef __MONOTONIC_ARENA_H__
+#define __MONOTONIC_ARENA_H__
+
+#include <cstddef>
+
+#include "rpools/tools/pool_utils.hpp"
+
+namespace rpools {
+
+/**
+ *  Represents an arena which allocates objects by bumping a pointer and
+ *  frees them all at once, e.g. the scratch data of a request.
+ *  @par
+ *  Memory is requested in chunks of consecutive pages (@see allocatePages)
+ *  which are kept in a list. `reset` moves back to the first chunk in
+ *  constant time, so the chunks are reused by the next request instead of
+ *  being freed. Nested scopes are supported with `mark` and `rewind` (or
+ *  with a `Scope`), which free everything allocated after the mark.
+ *  @note Destructors are never called by the arena and `MonotonicArena` is
+ *        not thread-safe.
+ */
+class MonotonicArena {
+private:
+    /** The header at the first byte of every chunk. */
+    struct Chunk {
+        Chunk* next;
+        /** The size of the chunk, including the header. */
+        size_t size;
+    };
+
+public:
+    /** The default number of pages of a chunk. */
+    static const size_t DEFAULT_CHUNK_PAGES = 16;
+
+    /**
+     *  A position of the arena, which is returned by `mark`.
+     */
+    struct Marker {
+        Chunk* chunk;
+        char* current;
+    };
+
+    /**
+     *  Marks the arena when it is created and rewinds it when it is
+     *  destroyed, so that the allocations of a nested scope are freed.
+     */
+    class Scope {
+    public:
+        explicit Scope(MonotonicArena& t_arena)
+            : m_arena(t_arena), m_marker(t_arena.mark()) {}
+        Scope(const Scope& other) = delete;
+        Scope& operator =(const Scope& other) = delete;
+        ~Scope() { m_arena.rewind(m_marker); }
+    private:
+        MonotonicArena& m_arena;
+        Marker m_marker;
+    };
+
+    /**
+     *  Creates a `MonotonicArena`. No memory is requested until the first
+     *  allocation.
+     *  @param t_chunkPages the number of pages of a chunk (larger
+     *                      allocations get a chunk of their own size)
+     */
+    explicit MonotonicArena(size_t t_chunkPages=DEFAULT_CHUNK_PAGES);
+
+    MonotonicArena(const MonotonicArena& other) = delete;
+    MonotonicArena& operator =(const MonotonicArena& other) = delete;
+
+    /**
+     *  Frees all the chunks.
+     */
+    ~MonotonicArena();
+
+    /**
+     *  Allocates `t_size` bytes which are aligned at `t_alignment`.
+     *  @param t_size the size of the allocation
+     *  @param t_alignment a power of 2 which is at most the page size
+     *  @return a pointer to the allocated memory, or nullptr if a chunk
+     *          could not be requested.
+     */
+    void* allocate(size_t t_size, size_t t_alignment=alignof(max_align_t)) {
+        char* ptr = m_current + mod(-reinterpret_cast<size_t>(m_current),
+                                    t_alignment);
+        if (m_current && ptr + t_size <= m_end) {
+            m_current = ptr + t_size;
+            return ptr;
+        }
+        return allocateSlow(t_size, t_alignment);
+    }
+
+    /**
+     *  Frees every allocation in constant time. The chunks are kept for the
+     *  next allocations.
+     */
+    void reset();
+
+    /**
+     *  @return the current position of the arena.
+     */
+    Marker mark() const { return { m_chunk, m_current }; }
+
+    /**
+     *  Frees every allocation made after `t_marker` was returned.
+     *  @param t_marker a position returned by `mark` after the last `reset`
+     */
+    void rewind(const Marker& t_marker);
+
+    /**
+     *  Frees all the chunks.
+     */
+    void release();
+
+    /**
+     *  @return the number of chunks that are currently allocated.
+     */
+    size_t getNumberOfChunks() const { return m_numOfChunks; }
+
+private:
+    Chunk* m_chunks = nullptr;
+    /** The chunk from which memory is allocated. */
+    Chunk* m_chunk = nullptr;
+    char* m_current = nullptr;
+    char* m_end = nullptr;
+    size_t m_chunkSize;
+    size_t m_numOfChunks = 0;
+
+    static char* getStart(Chunk* t_chunk) {
+        return reinterpret_cast<char*>(t_chunk + 1);
+    }
+
+    static char* getEnd(Chunk* t_chunk) {
+        return reinterpret_cast<char*>(t_chunk) + t_chunk->size;
+    }
+
+    /**
+     *  Moves to the next chunk which is large enough (requesting one if
+     *  there is none) and allocates from it.
+     */
+    void* allocateSlow(size_t t_size, size_t t_alignment);
+};
+}
+
+#endif // __MONOTONIC_ARENA_H__
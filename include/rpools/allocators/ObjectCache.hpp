@@ -0,0 +1,296 @@
+#ifndef __OBJECT_CACHE_H__
+#define __OBJECT_CACHE_H__
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "rpools/tools/LMLock.hpp"
+#include "rpools/tools/pool_utils.hpp"
+
+extern "C" {
+#include "rpools/avltree/avl_utils.h"
+}
+
+namespace rpools {
+
+/**
+ *  The `CacheHeader` is placed at the first byte of every page of an
+ *  `ObjectCache`. It is followed by the stack of the indices of the free
+ *  slots and then by the slots.
+ */
+struct CacheHeader {
+    /** Denotes the number of slots that are free. */
+    size_t freeSlots;
+    /** The previous and next page of the cache. */
+    CacheHeader* prev;
+    CacheHeader* next;
+};
+
+/**
+ *  Represents an object cache (a slab allocator in the style of Bonwick)
+ *  which keeps its objects constructed while they are free.
+ *  @par
+ *  Like `LinkedPool`, objects are kept in pages whose header is found by
+ *  masking a pointer. When a page is carved, the constructor of T runs once
+ *  for every slot, and `allocate` returns objects which are already
+ *  constructed. The destructor only runs when the page is reclaimed, so a
+ *  deallocated object must be returned in its constructed state (e.g. an
+ *  embedded vector is cleared but keeps its capacity).
+ *  @par
+ *  Because free objects are constructed, the free list of a page cannot be
+ *  kept in its slots, so every page has a stack of the indices of its free
+ *  slots after the header.
+ *  @note Empty pages are kept until `reclaim` is called (or the cache is
+ *  destroyed).
+ *  @tparam T the type of object to cache, which must be default
+ *            constructible and small enough that at least one object
+ *            fits in a page of 4096 bytes
+ */
+template<typename T>
+class ObjectCache {
+public:
+
+    /**
+     *  Creates an `ObjectCache`. No page is carved until the first
+     *  allocation.
+     */
+    ObjectCache();
+
+    ObjectCache(const ObjectCache& other) = delete;
+    ObjectCache& operator =(const ObjectCache& other) = delete;
+
+    /**
+     *  Destroys the objects of every page and frees the pages, including
+     *  the objects that are still allocated.
+     */
+    ~ObjectCache();
+
+    /**
+     *  @return a constructed object of type T, which was either carved from
+     *          a new page or deallocated before.
+     *  @throw std::bad_alloc if a page could not be allocated, or the
+     *         exception of the constructor of T while a page is carved.
+     */
+    T* allocate();
+
+    /**
+     *  Returns an object to the cache without destroying it.
+     *  @param t_ptr an object returned by `allocate`
+     */
+    void deallocate(T* t_ptr);
+
+    /**
+     *  Destroys the objects of the pages that have no allocated objects and
+     *  frees them.
+     *  @return the number of pages that were freed.
+     */
+    size_t reclaim();
+
+    /**
+     *  @return the number of T objects that fit in a page of memory.
+     */
+    size_t getPoolSize() { return m_poolSize; }
+
+    /**
+     *  @return the number of pages that are currently allocated.
+     */
+    size_t getNumberOfPools() { return m_numOfPools; }
+
+    /**
+     *  @return the number of pages that have no allocated objects.
+     */
+    size_t getNumberOfEmptyPools() { return m_numOfEmptyPools; }
+
+private:
+    using SlotIndex = uint32_t;
+
+    // 4096 bytes is the smallest page size of the supported platforms
+    static_assert(sizeof(CacheHeader) + alignof(T) - 1 + sizeof(T) +
+                  sizeof(SlotIndex) <= 4096,
+                  "An object of type T does not fit in a page.");
+
+    /** The pages that have a free slot. */
+    avl_tree m_freePools;
+    LMLock m_poolLock;
+    /** All the pages of the cache. */
+    CacheHeader* m_pools = nullptr;
+    CacheHeader* m_freePool = nullptr;
+    size_t m_poolSize;
+    size_t m_slotsOffset;
+    size_t m_numOfPools = 0;
+    size_t m_numOfEmptyPools = 0;
+
+    SlotIndex* getFreeStack(CacheHeader* t_header) {
+        return reinterpret_cast<SlotIndex*>(t_header + 1);
+    }
+
+    T* getSlots(CacheHeader* t_header) {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(t_header) +
+                                    m_slotsOffset);
+    }
+
+    /**
+     *  Allocates a page and constructs an object in every slot.
+     *  @return the header of the page.
+     */
+    CacheHeader* carvePool();
+
+    /**
+     *  Destroys the objects of a page, unlinks it and frees it.
+     */
+    void destroyPool(CacheHeader* t_header);
+};
+
+template<typename T>
+ObjectCache<T>::ObjectCache()
+    : m_freePools(),
+      m_poolLock() {
+    // every slot needs its object and its index in the stack, and the
+    // first slot may need padding to be aligned
+    size_t available = getPageSize() - sizeof(CacheHeader) - (alignof(T) - 1);
+    m_poolSize = available / (sizeof(T) + sizeof(SlotIndex));
+    m_slotsOffset = sizeof(CacheHeader) + m_poolSize * sizeof(SlotIndex);
+    size_t diff = mod(m_slotsOffset, alignof(T));
+    if (diff != 0) {
+        m_slotsOffset += alignof(T) - diff;
+    }
+}
+
+template<typename T>
+ObjectCache<T>::~ObjectCache() {
+    while (m_pools) {
+        CacheHeader* next = m_pools->next;
+        if (m_pools->freeSlots) {
+            pool_remove(&m_freePools, m_pools);
+        }
+        destroyPool(m_pools);
+        m_pools = next;
+    }
+}
+
+template<typename T>
+T* ObjectCache<T>::allocate() {
+    m_poolLock.lock();
+    CacheHeader* header = m_freePool;
+    if (!header) {
+        header = static_cast<CacheHeader*>(pool_first(&m_freePools));
+    }
+    if (!header) {
+        try {
+            header = carvePool();
+        } catch (...) {
+            m_poolLock.unlock();
+            throw;
+        }
+        pool_insert(&m_freePools, header);
+    }
+    if (header->freeSlots == m_poolSize) {
+        --m_numOfEmptyPools;
+    }
+    T* obj = getSlots(header) + getFreeStack(header)[--header->freeSlots];
+    // if the page becomes full, don't consider it in the list of pages
+    // that have some free slots
+    if (header->freeSlots == 0) {
+        pool_remove(&m_freePools, header);
+        header = static_cast<CacheHeader*>(pool_first(&m_freePools));
+    }
+    m_freePool = header;
+    m_poolLock.unlock();
+    return obj;
+}
+
+template<typename T>
+void ObjectCache<T>::deallocate(T* t_ptr) {
+    // get the page of t_ptr
+    auto header = reinterpret_cast<CacheHeader*>(
+        reinterpret_cast<size_t>(t_ptr) & getPoolMask()
+    );
+    m_poolLock.lock();
+    getFreeStack(header)[header->freeSlots] =
+        static_cast<SlotIndex>(t_ptr - getSlots(header));
+    if (header->freeSlots++ == 0) {
+        pool_insert(&m_freePools, header);
+    }
+    if (header->freeSlots == m_poolSize) {
+        ++m_numOfEmptyPools;
+    }
+    m_freePool = header;
+    m_poolLock.unlock();
+}
+
+template<typename T>
+size_t ObjectCache<T>::reclaim() {
+    m_poolLock.lock();
+    size_t reclaimed = 0;
+    CacheHeader* header = m_pools;
+    while (header) {
+        CacheHeader* next = header->next;
+        if (header->freeSlots == m_poolSize) {
+            pool_remove(&m_freePools, header);
+            destroyPool(header);
+            --m_numOfEmptyPools;
+            ++reclaimed;
+        }
+        header = next;
+    }
+    m_freePool = static_cast<CacheHeader*>(pool_first(&m_freePools));
+    m_poolLock.unlock();
+    return reclaimed;
+}
+
+template<typename T>
+CacheHeader* ObjectCache<T>::carvePool() {
+    void* page = allocatePages(1);
+    if (!page) {
+        throw std::bad_alloc();
+    }
+    auto header = new (page) CacheHeader();
+    T* slots = getSlots(header);
+    SlotIndex* freeStack = getFreeStack(header);
+    size_t i = 0;
+    try {
+        for (; i < m_poolSize; ++i) {
+            new (slots + i) T();
+            // the first slot is at the top of the stack
+            freeStack[m_poolSize - 1 - i] = static_cast<SlotIndex>(i);
+        }
+    } catch (...) {
+        while (i > 0) {
+            slots[--i].~T();
+        }
+        freePages(page);
+        throw;
+    }
+    header->freeSlots = m_poolSize;
+    header->prev = nullptr;
+    header->next = m_pools;
+    if (m_pools) {
+        m_pools->prev = header;
+    }
+    m_pools = header;
+    ++m_numOfPools;
+    ++m_numOfEmptyPools;
+    return header;
+}
+
+template<typename T>
+void ObjectCache<T>::destroyPool(CacheHeader* t_header) {
+    T* slots = getSlots(t_header);
+    for (size_t i = 0; i < m_poolSize; ++i) {
+        slots[i].~T();
+    }
+    if (t_header->prev) {
+        t_header->prev->next = t_header->next;
+    } else {
+        m_pools = t_header->next;
+    }
+    if (t_header->next) {
+        t_header->next->prev = t_header->prev;
+    }
+    --m_numOfPools;
+    freePages(t_header);
+}
+
+}
+#endif // __OBJECT_CACHE_H__
@@ -0,0 +1,97 @@
+#ifndef __OCCUPANCY_MAP_H__
+#define __OCCUPANCY_MAP_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rpools {
+
+/**
+ *  Represents the layout of the bitmaps which tell which slots of the pages
+ *  of an allocator are allocated.
+ *  @par
+ *  The bitmap of a page is not part of its header: its words follow the
+ *  header, and their number is derived from the number of slots of a page,
+ *  so that pages of any size are fully tracked. The functions which read or
+ *  write a bitmap take the words of the page.
+ *  @par
+ *  The index of a slot is computed with a multiplication by the reciprocal
+ *  of the slot size instead of a division, since it is done by every
+ *  allocation and deallocation. It is exact for offsets that are multiples
+ *  of the slot size, as long as both the slot size and the number of slots
+ *  are less than 2^16.
+ */
+class OccupancyMap {
+public:
+    /**
+     *  Creates an `OccupancyMap` of pages without a bitmap.
+     */
+    OccupancyMap() : m_words(0), m_reciprocal(0) {}
+
+    /**
+     *  @param t_slotSize the size of a slot
+     *  @param t_slots the number of slots of a page
+     */
+    OccupancyMap(size_t t_slotSize, size_t t_slots)
+        : m_words(getWords(t_slots)),
+          m_reciprocal(((uint64_t(1) << SHIFT) + t_slotSize - 1) /
+                       t_slotSize) {}
+
+    /**
+     *  @return the number of words of the bitmap of a page with `t_slots`
+     *          slots.
+     */
+    static size_t getWords(size_t t_slots) {
+        return (t_slots + 63) / 64;
+    }
+
+    /**
+     *  @return the number of bytes of the bitmap of a page.
+     */
+    size_t getSize() const { return m_words * sizeof(uint64_t); }
+
+    /**
+     *  @param t_offset the offset of a slot from the first slot of its page
+     *  @return the index of the slot.
+     */
+    size_t getSlot(size_t t_offset) const {
+        return (t_offset * m_reciprocal) >> SHIFT;
+    }
+
+    static void set(uint64_t* t_words, size_t t_slot) {
+        t_words[t_slot / 64] |= uint64_t(1) << (t_slot % 64);
+    }
+
+    static void reset(uint64_t* t_words, size_t t_slot) {
+        t_words[t_slot / 64] &= ~(uint64_t(1) << (t_slot % 64));
+    }
+
+    static bool test(const uint64_t* t_words, size_t t_slot) {
+        return (t_words[t_slot / 64] >> (t_slot % 64)) & 1;
+    }
+
+    /**
+     *  Calls `t_func` with the index of every allocated slot of a page, in
+     *  increasing order.
+     *  @param t_words the bitmap of the page
+     */
+    template<typename F>
+    void forEach(const uint64_t* t_words, F t_func) const {
+        for (size_t w = 0; w < m_words; ++w) {
+            uint64_t bits = t_words[w];
+            while (bits) {
+                t_func(w * 64 + __builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    static const unsigned SHIFT = 32;
+
+    size_t m_words;
+    uint64_t m_reciprocal;
+};
+}
+
+#endif // __OCCUPANCY_MAP_H__
@@ -19,21 +19,29 @@ struct PoolHeaderG {
      /** A `Node` which points to the next free slot of the pool, or
       *  to nullptr if there are no slots left. */
     Node head;
+    /** The allocator which created the pool. */
+    void* owner;
+    /** The previous and next page of the allocator. */
+    PoolHeaderG* prevPool;
+    PoolHeaderG* nextPool;
 
     /**
      *  Create a `PoolHeaderG` with non-default values.
      *  @param t_sizeOfSlot the size of a slot in the pool
      *  @param t_next the first empty pool slot
+     *  @param t_owner the allocator which created the pool
      */
-    PoolHeaderG(size_t t_sizeOfSlot, Node* t_next)
-        : occupiedSlots(0), sizeOfSlot(t_sizeOfSlot), head(t_next) {
+    PoolHeaderG(size_t t_sizeOfSlot, Node* t_next, void* t_owner)
+        : occupiedSlots(0), sizeOfSlot(t_sizeOfSlot), head(t_next),
+          owner(t_owner), prevPool(nullptr), nextPool(nullptr) {
 
     }
 
     bool operator ==(const PoolHeaderG& other) const {
         return occupiedSlots == other.occupiedSlots &&
             sizeOfSlot == other.sizeOfSlot &&
-            head.next == other.head.next;
+            head.next == other.head.next &&
+            owner == other.owner;
     }
 };
 }
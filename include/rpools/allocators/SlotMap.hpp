@@ -0,0 +1,209 @@
+#ifndef __SLOT_MAP_H__
+#define __SLOT_MAP_H__
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "rpools/allocators/LinkedPool.hpp"
+
+namespace rpools {
+
+/**
+ *  Represents a container which gives stable handles to its objects.
+ *  @par
+ *  The objects are allocated in the pages of a `LinkedPool<T>`, so their
+ *  addresses never change. A handle is the index of a slot and the
+ *  generation of the slot when the object was inserted. The generation is
+ *  incremented whenever an object is inserted or erased (so it is odd while
+ *  the slot holds an object), which makes handles of erased objects stale
+ *  in O(1) time.
+ *  @par
+ *  A dense array keeps a pointer to every object, so that iterating over
+ *  the objects does not skip over free slots. Erasing an object moves the
+ *  last pointer of the dense array into its place.
+ *  @note `SlotMap` is not thread-safe and the order of iteration changes
+ *        when objects are erased.
+ *  @tparam T the type of the objects
+ */
+template<typename T>
+class SlotMap {
+public:
+    /**
+     *  The handle of an object of the `SlotMap`.
+     */
+    struct Handle {
+        uint32_t index;
+        uint32_t generation;
+
+        bool operator ==(const Handle& other) const {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator !=(const Handle& other) const {
+            return !(*this == other);
+        }
+    };
+
+    /**
+     *  Iterates over the objects of the dense array.
+     */
+    class iterator {
+    public:
+        explicit iterator(typename std::vector<T*>::const_iterator t_it)
+            : m_it(t_it) {}
+        T& operator *() const { return **m_it; }
+        T* operator ->() const { return *m_it; }
+        iterator& operator ++() { ++m_it; return *this; }
+        bool operator ==(const iterator& other) const {
+            return m_it == other.m_it;
+        }
+        bool operator !=(const iterator& other) const {
+            return m_it != other.m_it;
+        }
+    private:
+        typename std::vector<T*>::const_iterator m_it;
+    };
+
+    SlotMap() = default;
+    SlotMap(const SlotMap& other) = delete;
+    SlotMap& operator =(const SlotMap& other) = delete;
+
+    /**
+     *  Destroys every object of the map.
+     */
+    ~SlotMap() { clear(); }
+
+    /**
+     *  Constructs an object in the map.
+     *  @param t_args the arguments of the constructor of T
+     *  @return the handle of the object.
+     */
+    template<typename... Args>
+    Handle insert(Args&&... t_args);
+
+    /**
+     *  Destroys the object of `t_handle`.
+     *  @return false if the handle is stale.
+     */
+    bool erase(Handle t_handle);
+
+    /**
+     *  @return the object of `t_handle`, or nullptr if the handle is stale.
+     */
+    T* get(Handle t_handle) const {
+        if (!contains(t_handle)) {
+            return nullptr;
+        }
+        return m_dense[m_slots[t_handle.index].index];
+    }
+
+    /**
+     *  @return true if `t_handle` refers to an object of the map.
+     */
+    bool contains(Handle t_handle) const {
+        return t_handle.index < m_slots.size() &&
+            (t_handle.generation & 1) &&
+            m_slots[t_handle.index].generation == t_handle.generation;
+    }
+
+    /**
+     *  Destroys every object of the map. All the handles become stale.
+     */
+    void clear();
+
+    /**
+     *  @return the number of objects of the map.
+     */
+    size_t size() const { return m_dense.size(); }
+
+    bool empty() const { return m_dense.empty(); }
+
+    iterator begin() const { return iterator(m_dense.begin()); }
+    iterator end() const { return iterator(m_dense.end()); }
+
+private:
+    /** Marks the end of the list of free slots. */
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct Slot {
+        uint32_t generation;
+        /** The index of the object in the dense array if the slot holds an
+         *  object, or else the next free slot. */
+        uint32_t index;
+    };
+
+    LinkedPool<T> m_pool;
+    std::vector<Slot> m_slots;
+    /** The first free slot. */
+    uint32_t m_freeSlot = NONE;
+    std::vector<T*> m_dense;
+    /** The slot of every object of the dense array. */
+    std::vector<uint32_t> m_denseSlots;
+};
+
+template<typename T>
+template<typename... Args>
+typename SlotMap<T>::Handle SlotMap<T>::insert(Args&&... t_args) {
+    // grow the arrays first, so that nothing throws after T is constructed
+    if (m_freeSlot == NONE) {
+        m_slots.push_back({ 0, NONE });
+        m_freeSlot = static_cast<uint32_t>(m_slots.size() - 1);
+    }
+    m_dense.reserve(m_dense.size() + 1);
+    m_denseSlots.reserve(m_denseSlots.size() + 1);
+    void* ptr = m_pool.allocate();
+    T* obj;
+    try {
+        obj = new (ptr) T(std::forward<Args>(t_args)...);
+    } catch (...) {
+        m_pool.deallocate(ptr);
+        throw;
+    }
+    uint32_t index = m_freeSlot;
+    Slot& slot = m_slots[index];
+    m_freeSlot = slot.index;
+    ++slot.generation;
+    slot.index = static_cast<uint32_t>(m_dense.size());
+    m_dense.push_back(obj);
+    m_denseSlots.push_back(index);
+    return { index, slot.generation };
+}
+
+template<typename T>
+bool SlotMap<T>::erase(Handle t_handle) {
+    if (!contains(t_handle)) {
+        return false;
+    }
+    Slot& slot = m_slots[t_handle.index];
+    T* obj = m_dense[slot.index];
+    obj->~T();
+    m_pool.deallocate(obj);
+    // move the last object of the dense array into the hole
+    m_dense[slot.index] = m_dense.back();
+    m_denseSlots[slot.index] = m_denseSlots.back();
+    m_slots[m_denseSlots[slot.index]].index = slot.index;
+    m_dense.pop_back();
+    m_denseSlots.pop_back();
+    ++slot.generation;
+    slot.index = m_freeSlot;
+    m_freeSlot = t_handle.index;
+    return true;
+}
+
+template<typename T>
+void SlotMap<T>::clear() {
+    for (size_t i = 0; i < m_dense.size(); ++i) {
+        Slot& slot = m_slots[m_denseSlots[i]];
+        m_dense[i]->~T();
+        m_pool.deallocate(m_dense[i]);
+        ++slot.generation;
+        slot.index = m_freeSlot;
+        m_freeSlot = m_denseSlots[i];
+    }
+    m_dense.clear();
+    m_denseSlots.clear();
+}
+
+}
+#endif // __SLOT_MAP_H__
@@ -0,0 +1,285 @@
+#ifndef __SOA_POOL_H__
+#define __SOA_POOL_H__
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "rpools/tools/pool_utils.hpp"
+
+namespace rpools {
+
+/** A sequence of indices (`std::index_sequence` is only part of C++14). */
+template<size_t... Is>
+struct IndexSequence {};
+
+template<size_t N, size_t... Is>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Is...> {};
+
+template<size_t... Is>
+struct MakeIndexSequence<0, Is...> {
+    using type = IndexSequence<Is...>;
+};
+
+/**
+ *  Represents a pool which keeps every field of its objects in its own
+ *  array (a struct of arrays), so that a loop over a single field reads
+ *  contiguous memory and can be vectorised.
+ *  @par
+ *  Objects are allocated in chunks of `CHUNK_SIZE` objects and every chunk
+ *  has a page aligned array for each field (@see allocatePages). An object
+ *  is an index; `index / CHUNK_SIZE` is its chunk and `index % CHUNK_SIZE`
+ *  is its position in the arrays of the chunk.
+ *  @par
+ *  Like `LinkedPool`, free slots are reused before a new chunk is
+ *  allocated, and when all the objects of a chunk are deallocated its
+ *  arrays are freed.
+ *  @note `SoAPool` is not thread-safe.
+ *  @tparam Fields the types of the fields, which must be trivially
+ *                 destructible
+ */
+template<typename... Fields>
+class SoAPool {
+public:
+    /** The number of objects of a chunk. */
+    static const size_t CHUNK_SIZE = 1024;
+
+    /** The type of the field `I`. */
+    template<size_t I>
+    using Field = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+    SoAPool() = default;
+    SoAPool(const SoAPool& other) = delete;
+    SoAPool& operator =(const SoAPool& other) = delete;
+
+    /**
+     *  Frees the arrays of every chunk.
+     */
+    ~SoAPool();
+
+    /**
+     *  Allocates an object. Its fields keep the values of the object which
+     *  was last deallocated at the same index (zero for new chunks).
+     *  @return the index of the object.
+     *  @throw std::bad_alloc if the arrays of a chunk could not be allocated.
+     */
+    size_t allocate();
+
+    /**
+     *  Deallocates the object at `t_index`.
+     */
+    void deallocate(size_t t_index);
+
+    /**
+     *  @return the field `I` of the object at `t_index`.
+     */
+    template<size_t I>
+    Field<I>& get(size_t t_index) {
+        return std::get<I>(m_chunks[t_index / CHUNK_SIZE].arrays)
+            [t_index % CHUNK_SIZE];
+    }
+
+    /**
+     *  @return true if the object at `t_index` is allocated.
+     */
+    bool isLive(size_t t_index) const {
+        const Chunk& chunk = m_chunks[t_index / CHUNK_SIZE];
+        size_t slot = t_index % CHUNK_SIZE;
+        return (chunk.occupancy[slot / 64] >> (slot % 64)) & 1;
+    }
+
+    /**
+     *  Calls `t_func(array, CHUNK_SIZE, firstIndex)` with the array of the
+     *  field `I` of every chunk. The arrays are page aligned and hold all
+     *  the slots of their chunk, so that the loop of `t_func` can be
+     *  vectorised without any gaps.
+     *  @warning the arrays include the free slots as well, so `t_func` must
+     *           either be harmless for them or check `isLive`.
+     */
+    template<size_t I, typename F>
+    void forEachSpan(F t_func) {
+        for (size_t c = 0; c < m_chunks.size(); ++c) {
+            Field<I>* array = std::get<I>(m_chunks[c].arrays);
+            if (array) {
+                t_func(static_cast<Field<I>*>(
+                           __builtin_assume_aligned(array, 64)),
+                       CHUNK_SIZE, c * CHUNK_SIZE);
+            }
+        }
+    }
+
+    /**
+     *  @return the number of objects that are allocated.
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     *  @return the number of chunks whose arrays are allocated.
+     */
+    size_t getNumberOfChunks() const { return m_numOfChunks; }
+
+private:
+    /** Marks a chunk which is not in `m_partialChunks`. */
+    static const size_t NONE = SIZE_MAX;
+
+    struct Chunk {
+        /** The array of every field, nullptr if the chunk is released. */
+        std::tuple<Fields*...> arrays;
+        size_t live;
+        /** The position of the chunk in `m_partialChunks`. */
+        size_t partialPos;
+        /** The free slots of the chunk. */
+        std::vector<uint16_t> freeSlots;
+        uint64_t occupancy[CHUNK_SIZE / 64];
+    };
+
+    static_assert(std::is_trivially_destructible<std::tuple<Fields...>>::value,
+                  "the fields are never destroyed");
+    static_assert(CHUNK_SIZE % 64 == 0 && CHUNK_SIZE <= UINT16_MAX + 1,
+                  "the slots of a chunk must fit in uint16_t");
+
+    std::vector<Chunk> m_chunks;
+    /** The chunks which have arrays and free slots. */
+    std::vector<size_t> m_partialChunks;
+    /** The chunks whose arrays were freed. */
+    std::vector<size_t> m_releasedChunks;
+    size_t m_size = 0;
+    size_t m_numOfChunks = 0;
+
+    using Indices = typename MakeIndexSequence<sizeof...(Fields)>::type;
+
+    /**
+     *  @return page aligned memory for the array of a field whose elements
+     *          have `t_size` bytes, or nullptr if the allocation failed.
+     */
+    static void* allocateArray(size_t t_size) {
+        size_t pageSize = getPageSize();
+        size_t pages = (CHUNK_SIZE * t_size + pageSize - 1) / pageSize;
+        void* array = allocatePages(pages);
+        if (array) {
+            std::memset(array, 0, pages * pageSize);
+        }
+        return array;
+    }
+
+    template<size_t... Is>
+    static bool allocateArrays(Chunk& t_chunk, IndexSequence<Is...>) {
+        bool allocated = true;
+        int expand[] = { 0, (std::get<Is>(t_chunk.arrays) =
+                                 static_cast<Fields*>(
+                                     allocateArray(sizeof(Fields))),
+                             allocated &= std::get<Is>(t_chunk.arrays) !=
+                                 nullptr,
+                             0)... };
+        (void)expand;
+        return allocated;
+    }
+
+    template<size_t... Is>
+    static void freeArrays(Chunk& t_chunk, IndexSequence<Is...>) {
+        int expand[] = { 0, (freePages(std::get<Is>(t_chunk.arrays)),
+                             std::get<Is>(t_chunk.arrays) = nullptr, 0)... };
+        (void)expand;
+    }
+
+    /**
+     *  Allocates the arrays of a released or new chunk and adds it to the
+     *  partial chunks.
+     */
+    void addChunk();
+
+    void removePartial(Chunk& t_chunk);
+};
+
+template<typename... Fields>
+SoAPool<Fields...>::~SoAPool() {
+    for (auto& chunk : m_chunks) {
+        freeArrays(chunk, Indices());
+    }
+}
+
+template<typename... Fields>
+size_t SoAPool<Fields...>::allocate() {
+    if (m_partialChunks.empty()) {
+        addChunk();
+    }
+    size_t c = m_partialChunks.back();
+    Chunk& chunk = m_chunks[c];
+    size_t slot = chunk.freeSlots.back();
+    chunk.freeSlots.pop_back();
+    chunk.occupancy[slot / 64] |= uint64_t(1) << (slot % 64);
+    // the chunk is full, don't consider it for the next allocations
+    if (++chunk.live == CHUNK_SIZE) {
+        removePartial(chunk);
+    }
+    ++m_size;
+    return c * CHUNK_SIZE + slot;
+}
+
+template<typename... Fields>
+void SoAPool<Fields...>::deallocate(size_t t_index) {
+    size_t c = t_index / CHUNK_SIZE;
+    size_t slot = t_index % CHUNK_SIZE;
+    Chunk& chunk = m_chunks[c];
+    chunk.occupancy[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    chunk.freeSlots.push_back(static_cast<uint16_t>(slot));
+    --m_size;
+    if (--chunk.live == 0) {
+        // the last object was deallocated => free the arrays
+        removePartial(chunk);
+        freeArrays(chunk, Indices());
+        chunk.freeSlots.clear();
+        m_releasedChunks.push_back(c);
+        --m_numOfChunks;
+    } else if (chunk.partialPos == NONE) {
+        chunk.partialPos = m_partialChunks.size();
+        m_partialChunks.push_back(c);
+    }
+}
+
+template<typename... Fields>
+void SoAPool<Fields...>::addChunk() {
+    if (m_releasedChunks.empty()) {
+        // a value initialised chunk has no arrays
+        m_chunks.emplace_back();
+        m_releasedChunks.push_back(m_chunks.size() - 1);
+    }
+    size_t c = m_releasedChunks.back();
+    Chunk& chunk = m_chunks[c];
+    // make sure that nothing is left half done if an allocation fails
+    chunk.freeSlots.reserve(CHUNK_SIZE);
+    m_partialChunks.reserve(m_partialChunks.size() + 1);
+    if (!allocateArrays(chunk, Indices())) {
+        freeArrays(chunk, Indices());
+        throw std::bad_alloc();
+    }
+    m_releasedChunks.pop_back();
+    // the first slot is allocated first
+    for (size_t slot = CHUNK_SIZE; slot > 0; --slot) {
+        chunk.freeSlots.push_back(static_cast<uint16_t>(slot - 1));
+    }
+    std::memset(chunk.occupancy, 0, sizeof(chunk.occupancy));
+    chunk.live = 0;
+    chunk.partialPos = m_partialChunks.size();
+    m_partialChunks.push_back(c);
+    ++m_numOfChunks;
+}
+
+template<typename... Fields>
+void SoAPool<Fields...>::removePartial(Chunk& t_chunk) {
+    if (t_chunk.partialPos == NONE) {
+        return;
+    }
+    // move the last partial chunk into the position of t_chunk
+    size_t last = m_partialChunks.back();
+    m_partialChunks[t_chunk.partialPos] = last;
+    m_chunks[last].partialPos = t_chunk.partialPos;
+    m_partialChunks.pop_back();
+    t_chunk.partialPos = NONE;
+}
+
+}
+#endif // __SOA_POOL_H__
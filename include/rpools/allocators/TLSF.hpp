@@ -0,0 +1,174 @@
+#ifndef __TLSF_H__
+#define __TLSF_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rpools/tools/pool_utils.hpp"
+
+namespace rpools {
+
+/**
+ *  Represents a Two-Level Segregated Fit allocator, which allocates objects
+ *  of variable sizes in bounded (constant) time.
+ *  @par
+ *  Memory is requested in spans of consecutive pages (@see allocatePages)
+ *  which are split into blocks. The free blocks are kept in segregated
+ *  lists: the first level divides sizes into powers of 2 and the second
+ *  level divides each power of 2 into `SL_COUNT` ranges. Two bitmaps tell
+ *  which lists are not empty, so that a large enough block is found
+ *  with a couple of bit scans. Neighbouring free blocks are merged when a
+ *  block is deallocated, and spans which become empty are released (one
+ *  span is always kept).
+ *  @note `TLSF` is not thread-safe.
+ */
+class TLSF {
+public:
+    /** The alignment of every allocation. */
+    static const size_t ALIGNMENT = 16;
+    /** The default size of the spans (in bytes). */
+    static const size_t DEFAULT_SPAN_SIZE = 256 * 1024;
+
+    /**
+     *  Creates a `TLSF` allocator. No memory is requested until the first
+     *  allocation.
+     *  @param t_spanSize the size of the spans that are requested, which is
+     *                    rounded up to a multiple of the page size
+     */
+    explicit TLSF(size_t t_spanSize=DEFAULT_SPAN_SIZE);
+
+    TLSF(const TLSF& other) = delete;
+    TLSF& operator =(const TLSF& other) = delete;
+
+    /**
+     *  Releases all the spans, even if they hold objects.
+     */
+    ~TLSF();
+
+    /**
+     *  Allocates `t_size` bytes which are aligned at `ALIGNMENT`.
+     *  @param t_size the size of the allocation
+     *  @return a pointer to the allocated memory, or nullptr if `t_size`
+     *          is larger than `getMaxAllocation()` or no span could be
+     *          requested.
+     */
+    void* allocate(size_t t_size);
+
+    /**
+     *  Deallocates memory which was allocated by `allocate`.
+     *  @param t_ptr the pointer which is freed (can be nullptr)
+     */
+    void deallocate(void* t_ptr);
+
+    /**
+     *  @return the largest allocation that fits in a span.
+     */
+    size_t getMaxAllocation() const { return m_maxAllocation; }
+
+    /**
+     *  @return the number of spans that are currently allocated.
+     */
+    size_t getNumberOfSpans() const { return m_numOfSpans; }
+
+    /**
+     *  @param t_ptr a pointer returned by `allocate`
+     *  @return the number of bytes that can be used at `t_ptr`, which is at
+     *          least the size that was requested.
+     */
+    static size_t getBlockSize(const void* t_ptr);
+
+private:
+    /** The header of every block of a span. */
+    struct Block {
+        /** The previous block of the span, or nullptr if it is the first. */
+        Block* prevPhys;
+        /** The size of the block without its header, and the flags. */
+        size_t size;
+        /** Only valid while the block is free. */
+        Block* nextFree;
+        Block* prevFree;
+    };
+
+    /** The header of every span. */
+    struct Span {
+        Span* prev;
+        Span* next;
+    };
+
+    /** The log2 of the number of second level lists of each first level. */
+    static const size_t SL_LOG2 = 4;
+    static const size_t SL_COUNT = 1 << SL_LOG2;
+    /** Sizes below `SMALL_BLOCK_SIZE` are all kept in the first level 0. */
+    static const size_t FL_SHIFT = SL_LOG2 + 4;
+    static const size_t SMALL_BLOCK_SIZE = 1 << FL_SHIFT;
+    static const size_t FL_COUNT = sizeof(size_t) * 8 - FL_SHIFT + 1;
+    /** The bytes that precede the memory of a block. */
+    static const size_t BLOCK_OVERHEAD = 2 * sizeof(void*);
+    /** A free block must have room for its free list pointers. */
+    static const size_t MIN_BLOCK_SIZE = 2 * sizeof(void*);
+    /** Set in `Block::size` when the block is free. */
+    static const size_t FREE_BIT = 1;
+    /** Set in `Block::size` when the previous block is free. */
+    static const size_t PREV_FREE_BIT = 2;
+
+    static_assert(sizeof(Span) % ALIGNMENT == 0 &&
+                  BLOCK_OVERHEAD % ALIGNMENT == 0,
+                  "blocks must stay aligned");
+
+    uint64_t m_flBitmap = 0;
+    uint32_t m_slBitmap[FL_COUNT];
+    Block* m_blocks[FL_COUNT][SL_COUNT];
+    Span* m_spans = nullptr;
+    size_t m_numOfSpans = 0;
+    size_t m_spanSize;
+    size_t m_maxAllocation;
+
+    static size_t getSize(const Block* t_block) {
+        return t_block->size & ~(ALIGNMENT - 1);
+    }
+
+    static Block* getNext(Block* t_block) {
+        return reinterpret_cast<Block*>(reinterpret_cast<char*>(t_block) +
+                                        BLOCK_OVERHEAD + getSize(t_block));
+    }
+
+    /**
+     *  @return the lists (`t_fl`, `t_sl`) to which a block of `t_size`
+     *          bytes belongs.
+     */
+    static void mapping(size_t t_size, size_t& t_fl, size_t& t_sl);
+
+    /**
+     *  @return the first lists (`t_fl`, `t_sl`) whose blocks are all at
+     *          least `t_size` bytes.
+     */
+    static void mappingSearch(size_t t_size, size_t& t_fl, size_t& t_sl);
+
+    /**
+     *  @return a free block of the lists (`t_fl`, `t_sl`) or of larger lists,
+     *          or nullptr if there is none. `t_fl` and `t_sl` are set to the
+     *          lists of the block.
+     */
+    Block* findSuitable(size_t& t_fl, size_t& t_sl);
+
+    void insertFree(Block* t_block);
+    void removeFree(Block* t_block);
+
+    /**
+     *  Splits the end of `t_block` into a free block, if it has more than
+     *  `t_size` bytes plus the room of a free block.
+     */
+    void split(Block* t_block, size_t t_size);
+
+    /**
+     *  Requests a span and adds its block to the free lists.
+     *  @return the block of the span, or nullptr if the request failed.
+     */
+    Block* addSpan();
+
+    /** Releases the span whose only block is `t_block`. */
+    void releaseSpan(Block* t_block);
+};
+}
+
+#endif // __TLSF_H__
@@ -11,6 +11,8 @@
 
 /**
  *  Allocates `t_size` bytes and aligns it according to `t_alignment`.
+ *  Allocations of 1 to 4 bytes whose alignment is at most their size are
+ *  made in the tiny classes (@see rpools::isTinyAllocation).
  *  @note This function will return a nullptr when allocation fails.
  *  @param t_size the size of the allocation
  *  @param t_alignment the alignment of the allocation which cannot
@@ -31,10 +33,103 @@ void* custom_new_no_throw(size_t t_size,
 void* custom_new(size_t t_size,
                  size_t t_alignment=alignof(max_align_t));
 
+/**
+ *  Allocates an object in the pool of the given size class.
+ *  This is called instead of `custom_new` by the `CustomNewDelete` pass when
+ *  the size of an allocation is known at compile time.
+ *  @note This function will return a nullptr when allocation fails.
+ *  @param t_class the size class of the allocation
+ *                 (@see rpools::getSizeClass)
+ *  @return a pointer to a slot of the size class.
+ */
+void* custom_new_class_no_throw(size_t t_class);
+
+/**
+ *  Allocates an object in the pool of the given size class.
+ *  @note This function throws bad_alloc when allocation fails.
+ *  @param t_class the size class of the allocation
+ *                 (@see rpools::getSizeClass)
+ *  @return a pointer to a slot of the size class.
+ */
+void* custom_new_class(size_t t_class);
+
+/**
+ *  Allocates an object in the pages of the given size class which hold
+ *  objects of the given lifetime.
+ *  This is called instead of `custom_new_class` by the `CustomNewDelete` pass
+ *  for the allocation sites that a profile marks as short-lived.
+ *  @note This function will return a nullptr when allocation fails.
+ *  @param t_class the size class of the allocation
+ *                 (@see rpools::getSizeClass)
+ *  @param t_lifetime the expected lifetime of the object
+ *                    (@see rpools::Lifetime)
+ *  @return a pointer to a slot of the size class.
+ */
+void* custom_new_lifetime_no_throw(size_t t_class, size_t t_lifetime);
+
+/**
+ *  Allocates an object in the pages of the given size class which hold
+ *  objects of the given lifetime.
+ *  @note This function throws bad_alloc when allocation fails.
+ *  @param t_class the size class of the allocation
+ *                 (@see rpools::getSizeClass)
+ *  @param t_lifetime the expected lifetime of the object
+ *                    (@see rpools::Lifetime)
+ *  @return a pointer to a slot of the size class.
+ */
+void* custom_new_lifetime(size_t t_class, size_t t_lifetime);
+
+/**
+ *  Allocates an object of the given type in the pool of its size class, or
+ *  in a pool of its own if the type is allocated often.
+ *  This is called instead of `custom_new_class` by the `CustomNewDelete` pass
+ *  when the allocated type is known at compile time.
+ *  @note This function will return a nullptr when allocation fails.
+ *  @param t_class the size class of the allocation
+ *                 (@see rpools::getSizeClass)
+ *  @param t_typeId a non-zero ID which is unique to the allocated type
+ *  @return a pointer to a slot of the size class.
+ */
+void* custom_new_typed_no_throw(size_t t_class, size_t t_typeId);
+
+/**
+ *  Allocates an object of the given type in the pool of its size class, or
+ *  in a pool of its own if the type is allocated often.
+ *  @note This function throws bad_alloc when allocation fails.
+ *  @param t_class the size class of the allocation
+ *                 (@see rpools::getSizeClass)
+ *  @param t_typeId a non-zero ID which is unique to the allocated type
+ *  @return a pointer to a slot of the size class.
+ */
+void* custom_new_typed(size_t t_class, size_t t_typeId);
+
 /**
  *  Frees up the memory that starts at `t_ptr`.
  *  @param t_ptr the pointer that is freed
  */
 void custom_delete(void* t_ptr) noexcept;
 
+/**
+ *  Frees up the memory that starts at `t_ptr`, which was allocated with the
+ *  given size. This is called instead of `custom_delete` by the
+ *  `CustomNewDelete` pass when the size of the object is known at compile
+ *  time, and it does not check whether the memory was malloc-d.
+ *  @param t_ptr the pointer that is freed
+ *  @param t_size the size which was passed to `custom_new`
+ *  @param t_alignment the alignment which was passed to `custom_new`
+ */
+void custom_delete_sized(void* t_ptr, size_t t_size,
+                         size_t t_alignment=alignof(max_align_t)) noexcept;
+
+/**
+ *  Registers the manifest of a module, which the `CustomNewDelete` pass emits
+ *  and registers from a global constructor. The pools of the size classes
+ *  in the manifest are created and pages are reserved for them, depending on
+ *  the number of allocation sites of all the modules.
+ *  @param t_sites the number of allocation sites of each size class
+ *  @param t_numOfClasses the number of elements of `t_sites`
+ */
+void custom_new_register_manifest(const size_t* t_sites,
+                                  size_t t_numOfClasses) noexcept;
+
 #endif // __CUSTOM_NEW_DELETE_H__
@@ -0,0 +1,126 @@
+/**
+ *  @file size_classes.hpp
+ *  The size classes of `custom_new`. They are shared between the runtime
+ *  and the `CustomNewDelete` LLVM pass, which resolves the size class of
+ *  allocations of a constant size at compile time.
+ */
+
+#ifndef __SIZE_CLASSES_H__
+#define __SIZE_CLASSES_H__
+
+#include <cstddef>
+
+namespace rpools {
+
+/** Allocations larger than this are not allocated in a pool because
+ *  malloc performs equally well on them. */
+const size_t CUSTOM_NEW_THRESHOLD = 128;
+
+/** The number of size classes (one for every multiple of 8 up to
+ *  `CUSTOM_NEW_THRESHOLD`). */
+const size_t NUM_OF_SIZE_CLASSES = CUSTOM_NEW_THRESHOLD / sizeof(void*);
+
+/** Allocations of at most this many bytes are allocated in the tiny
+ *  classes, whose slots are smaller than a pointer. */
+const size_t TINY_THRESHOLD = 4;
+
+/** The number of tiny classes (slots of 1, 2 and 4 bytes). */
+const size_t NUM_OF_TINY_CLASSES = 3;
+
+/**
+ *  The expected lifetime of an allocation. Objects of different lifetimes
+ *  are allocated in different pages, so that long-lived objects do not keep
+ *  the pages of short-lived objects alive.
+ */
+enum Lifetime {
+    LONG_LIVED = 0,
+    SHORT_LIVED = 1,
+    NUM_OF_LIFETIMES
+};
+
+/**
+ *  @param t_size the size of an allocation which is at most
+ *                `CUSTOM_NEW_THRESHOLD`
+ *  @param t_alignment the alignment of the allocation
+ *  @return the index of the size class which holds the allocation.
+ */
+inline size_t getSizeClass(size_t t_size, size_t t_alignment) {
+    const size_t mod = sizeof(void*) - 1;
+    // round up to the next multiple of sizeof(void*), a 0 byte allocation
+    // still needs a properly aligned slot
+    t_size = t_size == 0 ? sizeof(void*) : (t_size + mod) & ~mod;
+    // adds 8 in the case when a pool of <t_size> cannot accommodate
+    // an allocation request of alignment <t_alignment>
+    // say t_size is 40 and t_alignment is 16
+    // we have defined that pools that are not divisible by
+    // 16, have alignment 8, otherwise 16
+    // 40 % 16 != 0 -> place the request in a pool that holds
+    // objects of size 48 (also note 48 % 16 == 0 -> has an alignment of 16)
+    t_size += (t_size & (t_alignment - 1)) == 0 ? 0 : sizeof(void*);
+    return t_size / sizeof(void*) - 1;
+}
+
+/**
+ *  @param t_class the index of a size class
+ *  @return the size of the slots of the given size class.
+ */
+inline size_t getClassSize(size_t t_class) {
+    return (t_class + 1) * sizeof(void*);
+}
+
+/**
+ *  @param t_class the index of a size class
+ *  @return the alignment of the slots of the given size class.
+ */
+inline size_t getClassAlignment(size_t t_class) {
+    return (getClassSize(t_class) & (alignof(max_align_t) - 1)) == 0 ?
+        alignof(max_align_t) : sizeof(void*);
+}
+
+/**
+ *  @param t_size the size of an allocation which is at most
+ *                `TINY_THRESHOLD` and not 0
+ *  @return the index of the tiny class which holds the allocation.
+ */
+inline size_t getTinyClass(size_t t_size) {
+    return t_size <= 1 ? 0 : t_size <= 2 ? 1 : 2;
+}
+
+/**
+ *  @param t_class the index of a tiny class
+ *  @return the size of the slots of the given tiny class, which is also
+ *          their alignment.
+ */
+inline size_t getTinyClassSize(size_t t_class) {
+    return size_t(1) << t_class;
+}
+
+/**
+ *  @param t_size the size of an allocation whose type is unknown
+ *  @return the largest alignment that an object of `t_size` bytes can need,
+ *          which is the largest power of 2 that is at most `t_size` (and at
+ *          most `alignof(max_align_t)`).
+ */
+inline size_t getNaturalAlignment(size_t t_size) {
+    if (t_size == 0) {
+        return alignof(max_align_t);
+    }
+    size_t alignment = alignof(max_align_t);
+    while (alignment > t_size) {
+        alignment >>= 1;
+    }
+    return alignment;
+}
+
+/**
+ *  @param t_size the size of an allocation
+ *  @param t_alignment the alignment of the allocation
+ *  @return true if the allocation is made in a tiny class.
+ */
+inline bool isTinyAllocation(size_t t_size, size_t t_alignment) {
+    return t_size != 0 && t_size <= TINY_THRESHOLD &&
+        t_alignment <= getTinyClassSize(getTinyClass(t_size));
+}
+}
+
+#endif // __SIZE_CLASSES_H__
@@ -2,6 +2,7 @@
 #define __POOL_UTILS_H__
 
 #include <cstddef>
+#include <cstdlib>
 #include <unistd.h>
 #include <cmath>
 
@@ -26,6 +27,23 @@ inline size_t getPoolMask() {
     return poolMask;
 }
 
+/**
+ *  Allocates page aligned memory, which is where pools keep their objects.
+ *  @param t_pages the number of consecutive pages
+ *  @return a pointer to the first page, or nullptr if the allocation failed.
+ */
+inline void* allocatePages(size_t t_pages) {
+    return aligned_alloc(getPageSize(), t_pages * getPageSize());
+}
+
+/**
+ *  Frees pages which were allocated with `allocatePages`.
+ *  @param t_pages a pointer to the first page
+ */
+inline void freePages(void* t_pages) {
+    free(t_pages);
+}
+
 /**
  *  @param t_l the lhs of the `%` operator
  *  @param t_powOfTwo a power of 2 which is also the rhs of the `%` operator
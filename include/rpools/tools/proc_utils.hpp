@@ -33,3 +33,11 @@ std::string getStackUsage() {
 std::string getPeakHeapUsage() {
     return __getStatusField("VmPeak");
 }
+
+std::string getResidentSetSize() {
+    return __getStatusField("VmRSS");
+}
+
+std::string getPeakResidentSetSize() {
+    return __getStatusField("VmHWM");
+}
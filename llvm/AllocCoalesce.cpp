@@ -0,0 +1,250 @@
+#include <llvm/Pass.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#include <algorithm>
+#include <vector>
+
+#include "common.hpp"
+#include "rpools/custom_new/size_classes.hpp"
+
+using namespace llvm;
+using namespace legacy;
+using namespace custom_pass;
+using std::vector;
+
+static cl::opt<unsigned> MaxCoalescedSize(
+  "coalesce-max-size", cl::init(rpools::CUSTOM_NEW_THRESHOLD),
+  cl::desc("The largest allocation that can be created by merging "
+           "allocations (in bytes)"));
+
+namespace {
+
+/** An allocation which can be merged with others. */
+struct Candidate {
+  /** The call which allocates the object. */
+  CallInst* alloc;
+  /** The only call which deallocates the object. */
+  CallInst* dealloc;
+  uint64_t size;
+  size_t alignment;
+  /** The offset of the object inside of the merged allocation. */
+  uint64_t offset;
+  /** The lifetime argument of `custom_new_lifetime`, nullptr otherwise. */
+  ConstantInt* lifetime;
+};
+
+/**
+ *  Merges allocations that are made in the same basic block and that are
+ *  deallocated in the same basic block into a single `custom_new` call,
+ *  and replaces their deallocations with a single `custom_delete` call.
+ *  @par
+ *  An allocation is merged when:
+ *  * it is a call (not an invoke) to a throwing allocation function other
+ *    than `custom_new_typed`, because the pool of a hot type only holds
+ *    objects of the size class of the type
+ *  * its size is a constant
+ *  * it never escapes its function (@see custom_pass::doesNotEscape)
+ *  * it is deallocated exactly once, by a call
+ *  @par
+ *  Each object is placed at an offset of the merged allocation which
+ *  satisfies its alignment. The objects that are deallocated first live
+ *  until the last object of the group is deallocated.
+ *  @par
+ *  `custom_new_lifetime` allocations are only merged with allocations of
+ *  the same lifetime, into a `custom_new_lifetime` of that lifetime, so
+ *  that short-lived objects stay out of the pages of long-lived ones.
+ *  @note The pass runs at the end of the pipeline, after `HeapToStack`, so
+ *        that the allocations which can be moved to the stack are not
+ *        merged first.
+ */
+struct AllocCoalesce : public FunctionPass {
+  static char ID;
+
+  AllocCoalesce() : FunctionPass(ID) {}
+
+  /**
+   *  @param t_inst an instruction
+   *  @param t_candidate set to the description of `t_inst`
+   *  @return whether `t_inst` is an allocation which can be merged.
+   */
+  static bool isCandidate(Instruction& t_inst, Candidate& t_candidate) {
+    auto ci = dyn_cast<CallInst>(&t_inst);
+    if (!ci) {
+      return false;
+    }
+    CallSite cs(ci);
+    std::string name = getCalledName(cs);
+    // the result of nothrow allocations is compared against nullptr
+    bool throws = find(NEW_OPS.begin(), NEW_OPS.end(), name) != NEW_OPS.end()
+      || name == CUSTOM_NEW_OPS[0] || name == CUSTOM_NEW_CLASS_OPS[0];
+    ConstantInt* lifetime = nullptr;
+    if (name == CUSTOM_NEW_CLASS_OPS[4]) {
+      lifetime = dyn_cast<ConstantInt>(cs.getArgument(1));
+      throws = lifetime != nullptr;
+    }
+    uint64_t size = 0;
+    if (!throws || !getAllocationSize(cs, size) || size == 0 ||
+        size > getMaxSize(lifetime)) {
+      return false;
+    }
+    vector<Instruction*> deletes;
+    if (!doesNotEscape(ci, deletes) || deletes.size() != 1 ||
+        !isa<CallInst>(deletes[0])) {
+      return false;
+    }
+    t_candidate = { ci, cast<CallInst>(deletes[0]), size,
+                    getAllocationAlignment(cs), 0, lifetime };
+    return true;
+  }
+
+  /**
+   *  @param t_lifetime the lifetime of the allocations of a group
+   *  @return the largest size of a merged allocation.
+   */
+  static uint64_t getMaxSize(ConstantInt* t_lifetime) {
+    uint64_t maxSize = MaxCoalescedSize;
+    // custom_new_lifetime only takes size classes
+    if (t_lifetime) {
+      maxSize = std::min<uint64_t>(maxSize, rpools::CUSTOM_NEW_THRESHOLD);
+    }
+    return maxSize;
+  }
+
+  /**
+   *  Replaces the allocations of `t_group` with a single allocation.
+   *  @param t_group at least 2 allocations with the same deallocation block
+   *  @param t_size the size of the merged allocation
+   */
+  static void merge(vector<Candidate>& t_group, uint64_t t_size) {
+    Module* mod = t_group[0].alloc->getModule();
+    LLVMContext& context = mod->getContext();
+    size_t alignment = 1;
+    for (auto& candidate : t_group) {
+      alignment = std::max(alignment, candidate.alignment);
+    }
+    IRBuilder<> builder(t_group[0].alloc);
+    Value* base = nullptr;
+    if (ConstantInt* lifetime = t_group[0].lifetime) {
+      Constant* customNewLifetime = mod->getOrInsertFunction(
+        CUSTOM_NEW_LIFETIME_MANGLED,
+        FunctionType::get(Type::getInt8PtrTy(context),
+                          { Type::getInt64Ty(context),
+                            Type::getInt64Ty(context) }, false));
+      base = builder.CreateCall(customNewLifetime, {
+        builder.getInt64(rpools::getSizeClass(t_size, alignment)),
+        lifetime });
+    } else if (t_size <= rpools::CUSTOM_NEW_THRESHOLD) {
+      Constant* customNewClass = mod->getOrInsertFunction(
+        CUSTOM_NEW_CLASS_MANGLED,
+        FunctionType::get(Type::getInt8PtrTy(context),
+                          { Type::getInt64Ty(context) }, false));
+      base = builder.CreateCall(customNewClass, {
+        builder.getInt64(rpools::getSizeClass(t_size, alignment)) });
+    } else {
+      Constant* customNew = mod->getOrInsertFunction(
+        CUSTOM_NEW_MANGLED,
+        FunctionType::get(Type::getInt8PtrTy(context),
+                          { Type::getInt64Ty(context),
+                            Type::getInt64Ty(context) }, false));
+      base = builder.CreateCall(customNew, { builder.getInt64(t_size),
+                                             builder.getInt64(alignment) });
+    }
+    // the last deallocation of the group frees the merged allocation
+    CallInst* last = t_group[0].dealloc;
+    for (auto& candidate : t_group) {
+      for (auto& inst : *last->getParent()) {
+        if (&inst == candidate.dealloc) {
+          break;
+        } else if (&inst == last) {
+          // candidate.dealloc comes after last
+          last = candidate.dealloc;
+          break;
+        }
+      }
+    }
+    Constant* customDelete = mod->getOrInsertFunction(
+      CUSTOM_DELETE_MANGLED,
+      FunctionType::get(Type::getVoidTy(context),
+                        { Type::getInt8PtrTy(context) }, false));
+    IRBuilder<>(last).CreateCall(customDelete, { base });
+    for (auto& candidate : t_group) {
+      candidate.dealloc->eraseFromParent();
+      IRBuilder<> gepBuilder(candidate.alloc);
+      Value* ptr = candidate.offset == 0 ? base :
+        gepBuilder.CreateConstInBoundsGEP1_64(base, candidate.offset);
+      candidate.alloc->replaceAllUsesWith(ptr);
+      candidate.alloc->eraseFromParent();
+    }
+  }
+
+  bool runOnBasicBlock(BasicBlock& t_bb) {
+    bool changed = false;
+    vector<vector<Candidate>> groups;
+    // the size of each group
+    vector<uint64_t> sizes;
+    for (auto& inst : t_bb) {
+      Candidate candidate;
+      if (!isCandidate(inst, candidate)) {
+        continue;
+      }
+      // find a group of the same lifetime which is deallocated in the same
+      // place and which has space left
+      bool added = false;
+      for (size_t i = 0; i < groups.size() && !added; ++i) {
+        if (groups[i][0].dealloc->getParent() !=
+            candidate.dealloc->getParent() ||
+            groups[i][0].lifetime != candidate.lifetime) {
+          continue;
+        }
+        uint64_t offset = (sizes[i] + candidate.alignment - 1) &
+          ~(uint64_t)(candidate.alignment - 1);
+        if (offset + candidate.size <= getMaxSize(candidate.lifetime)) {
+          candidate.offset = offset;
+          sizes[i] = offset + candidate.size;
+          groups[i].push_back(candidate);
+          added = true;
+        }
+      }
+      if (!added) {
+        groups.push_back({ candidate });
+        sizes.push_back(candidate.size);
+      }
+    }
+    for (size_t i = 0; i < groups.size(); ++i) {
+      if (groups[i].size() > 1) {
+        merge(groups[i], sizes[i]);
+        changed = true;
+      }
+    }
+    return changed;
+  }
+
+  bool runOnFunction(Function& func) override {
+    bool changed = false;
+    for (auto& bb : func) {
+      changed |= runOnBasicBlock(bb);
+    }
+    return changed;
+  }
+}; // end of struct AllocCoalesce
+}  // end of anonymous namespace
+
+char AllocCoalesce::ID = 0;
+
+static RegisterPass<AllocCoalesce> X("alloc-coalesce",
+                                     "AllocCoalesce Pass",
+                                     false /* Only looks at CFG */,
+                                     false /* Analysis Pass */);
+
+static void registerMyPass(const PassManagerBuilder &,
+                           PassManagerBase &PM) {
+  PM.add(new AllocCoalesce());
+}
+static RegisterStandardPasses
+RegisterMyPass(PassManagerBuilder::EP_OptimizerLast,
+               registerMyPass);
@@ -6,11 +6,17 @@
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
 #include <algorithm>
+#include <fstream>
+#include <set>
 #include <vector>
 #include <map>
 
 #include "common.hpp"
+#include "rpools/custom_new/size_classes.hpp"
 
 using namespace llvm;
 using namespace legacy;
@@ -19,11 +25,53 @@ using std::vector;
 using std::map;
 using std::find;
 
+static cl::opt<bool> EnableTypedPools(
+  "custom-new-typed", cl::init(true),
+  cl::desc("Pass the ID of the allocated type to the runtime, which gives "
+           "the types that are allocated often a pool of their own"));
+
+static cl::opt<bool> EnableManifest(
+  "custom-new-manifest", cl::init(true),
+  cl::desc("Register the size classes which are used by the module at "
+           "startup, so that their pools are created up front"));
+
+static cl::opt<std::string> ReportFile(
+  "custom-new-report", cl::init(""),
+  cl::desc("Append the number of allocation sites of each size class of the "
+           "module to the given file"));
+
+static cl::opt<std::string> LifetimeProfile(
+  "custom-new-lifetimes", cl::init(""),
+  cl::desc("A profile with a 'short <function>' line for every function "
+           "whose allocations are short-lived"));
+
 namespace {
 /**
  *  Change all occurences of `operator new` with `custom_new` and all occurences
  *  of `operator delete` with `custom_delete`
  *  @note All versions of operator new and delete are considered.
+ *  @par
+ *  When the size of an allocation is a constant which fits in a pool, its
+ *  size class is resolved at compile time and `custom_new_class` is called
+ *  instead, which skips the rounding of the size at runtime. If the
+ *  allocated type is a named struct, `custom_new_typed` is called with an ID
+ *  of the type as well (unless `-custom-new-typed=false` is given).
+ *  @par
+ *  When the size of a deallocated object is known, because it was
+ *  allocated in the same function with a constant size or because a sized
+ *  operator delete is called, `custom_delete_sized` is called instead of
+ *  `custom_delete`, which skips the check for malloc-d memory at runtime.
+ *  @par
+ *  The allocations of the functions which are marked as short-lived by the
+ *  profile that is given with `-custom-new-lifetimes=<file>` call
+ *  `custom_new_lifetime` instead, so that they are allocated in other pages
+ *  than the long-lived objects of their size class.
+ *  @par
+ *  The number of allocation sites of each size class is emitted as a
+ *  manifest, which a global constructor passes to
+ *  `custom_new_register_manifest`, and can be appended to a report file
+ *  (`-custom-new-report=<file>`), one `<module> <size> <sites>` line per
+ *  size class.
  */
 struct CustomNewDelete : public BasicBlockPass {
   static char ID;
@@ -31,29 +79,281 @@ struct CustomNewDelete : public BasicBlockPass {
   static const StringRef CUSTOM_NEW_NAME;
   /** Mangled custom_new_no_throw function name. */
   static const StringRef CUSTOM_NEW_NO_THROW_NAME;
+  /** Mangled custom_new_class function name. */
+  static const StringRef CUSTOM_NEW_CLASS_NAME;
+  /** Mangled custom_new_class_no_throw function name. */
+  static const StringRef CUSTOM_NEW_CLASS_NO_THROW_NAME;
+  /** Mangled custom_new_typed function name. */
+  static const StringRef CUSTOM_NEW_TYPED_NAME;
+  /** Mangled custom_new_typed_no_throw function name. */
+  static const StringRef CUSTOM_NEW_TYPED_NO_THROW_NAME;
+  /** Mangled custom_new_lifetime function name. */
+  static const StringRef CUSTOM_NEW_LIFETIME_NAME;
+  /** Mangled custom_new_lifetime_no_throw function name. */
+  static const StringRef CUSTOM_NEW_LIFETIME_NO_THROW_NAME;
   /** Mangled custom_delete function name. */
   static const StringRef CUSTOM_DELETE_NAME;
+  /** Mangled custom_delete_sized function name. */
+  static const StringRef CUSTOM_DELETE_SIZED_NAME;
+  /** Mangled custom_new_register_manifest function name. */
+  static const StringRef REGISTER_MANIFEST_NAME;
   /** The declaration of custom_new inside of the module. */
   static Function* CUSTOM_NEW_FUNC;
   /** The declaration of custom_new_no_throw inside of the module. */
   static Function* CUSTOM_NEW_NO_THROW_FUNC;
+  /** The declaration of custom_new_class inside of the module. */
+  static Function* CUSTOM_NEW_CLASS_FUNC;
+  /** The declaration of custom_new_class_no_throw inside of the module. */
+  static Function* CUSTOM_NEW_CLASS_NO_THROW_FUNC;
+  /** The declaration of custom_new_typed inside of the module. */
+  static Function* CUSTOM_NEW_TYPED_FUNC;
+  /** The declaration of custom_new_typed_no_throw inside of the module. */
+  static Function* CUSTOM_NEW_TYPED_NO_THROW_FUNC;
+  /** The declaration of custom_new_lifetime inside of the module. */
+  static Function* CUSTOM_NEW_LIFETIME_FUNC;
+  /** The declaration of custom_new_lifetime_no_throw inside of the
+   *  module. */
+  static Function* CUSTOM_NEW_LIFETIME_NO_THROW_FUNC;
   /** The declaration of custom_delete inside of the module. */
   static Function* CUSTOM_DELETE_FUNC;
+  /** The declaration of custom_delete_sized inside of the module. */
+  static Function* CUSTOM_DELETE_SIZED_FUNC;
   /** A mapping from operator news to their `custom_new` correspondent. */
   static const map<StringRef, Function**> OP_TO_CUSTOM;
+  /** A mapping from operator news to their `custom_new_class`
+   *  correspondent. */
+  static const map<StringRef, Function**> OP_TO_CUSTOM_CLASS;
+  /** A mapping from operator news to their `custom_new_typed`
+   *  correspondent. */
+  static const map<StringRef, Function**> OP_TO_CUSTOM_TYPED;
+  /** A mapping from operator news to their `custom_new_lifetime`
+   *  correspondent. */
+  static const map<StringRef, Function**> OP_TO_CUSTOM_LIFETIME;
+  /** The names of the functions whose allocations are short-lived. */
+  static std::set<std::string> SHORT_LIVED_FUNCS;
 
-  static size_t getAlignmentFromInst(llvm::Instruction* inst,
-                                     const DataLayout& dataLayout) {
-    size_t alignment = alignof(max_align_t);
+  /**
+   *  Reads the `-custom-new-lifetimes` profile into `SHORT_LIVED_FUNCS`.
+   *  Every line of the profile is `short <function>`, where the function
+   *  name may be mangled or demangled.
+   */
+  static void readLifetimeProfile() {
+    SHORT_LIVED_FUNCS.clear();
+    if (LifetimeProfile.empty()) {
+      return;
+    }
+    std::ifstream profile(LifetimeProfile);
+    if (!profile) {
+      errs() << "custom-new-lifetimes: cannot open " << LifetimeProfile
+             << "\n";
+      return;
+    }
+    std::string lifetime, name;
+    while (profile >> lifetime && std::getline(profile, name)) {
+      rtrim(name);
+      name.erase(0, name.find_first_not_of(' '));
+      if (lifetime == "short") {
+        SHORT_LIVED_FUNCS.insert(name);
+      }
+    }
+  }
+
+  /**
+   *  @return whether the profile marks the allocations of `t_func` as
+   *          short-lived.
+   */
+  static bool isShortLived(const Function& t_func) {
+    return !SHORT_LIVED_FUNCS.empty() &&
+      (SHORT_LIVED_FUNCS.count(t_func.getName().str()) ||
+       SHORT_LIVED_FUNCS.count(getDemangledName(t_func.getName().str())));
+  }
+
+  /**
+   *  @param inst the instruction which follows a call to operator new
+   *  @return the allocated type, or nullptr if it is unknown.
+   */
+  static Type* getTypeFromInst(llvm::Instruction* inst) {
     // check if the instruction is a bitcast
     // because it holds the type, therefore the alignment
     if (inst && isa<BitCastInst>(*inst)) {
       auto& bci = cast<BitCastInst>(*inst);
-      auto& pt = cast<PointerType>(*bci.getDestTy());
-      Type* type = pt.getPointerElementType();
-      alignment = getAlignment(dataLayout, type);
+      if (auto pt = dyn_cast<PointerType>(bci.getDestTy())) {
+        return pt->getPointerElementType();
+      }
+    }
+    return nullptr;
+  }
+
+  static size_t getAlignmentFromType(Type* type,
+                                     const DataLayout& dataLayout) {
+    return type ? getAlignment(dataLayout, type) : alignof(max_align_t);
+  }
+
+  /**
+   *  @param type the allocated type, or nullptr
+   *  @return an ID which is the same in every module for the same named
+   *          struct, or 0 if `type` is not a named struct.
+   */
+  static uint64_t getTypeId(Type* type) {
+    auto st = dyn_cast_or_null<StructType>(type);
+    if (!EnableTypedPools || !st || !st->hasName()) {
+      return 0;
+    }
+    // 64-bit FNV-1a hash of the name
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : st->getName()) {
+      hash ^= (unsigned char)c;
+      hash *= 1099511628211ULL;
+    }
+    // 0 is reserved for unknown types
+    return hash ? hash : 1;
+  }
+
+  /**
+   *  @param t_name the demangled name of an operator new
+   *  @param t_size the size operand of the operator new call
+   *  @param t_type the allocated type, or nullptr if it is unknown
+   *  @param t_dataLayout the data layout of the module
+   *  @param t_shortLived whether the allocation is expected to be
+   *                      short-lived
+   *  @param t_builder the builder which creates the arguments
+   *  @return the function which replaces operator new and its arguments:
+   *          if `t_size` is a constant that fits in a pool,
+   *          `custom_new_lifetime(class, SHORT_LIVED)` for short-lived
+   *          allocations, `custom_new_typed(class, id)` if the type has an
+   *          ID and `custom_new_class(class)` otherwise. If it does not fit
+   *          in a pool or it is tiny, `custom_new(size, alignment)`.
+   */
+  static std::pair<Function*, vector<Value*>>
+  getCustomNew(const std::string& t_name, Value* t_size, Type* t_type,
+               const DataLayout& t_dataLayout, bool t_shortLived,
+               IRBuilder<>& t_builder) {
+    size_t alignment = getAlignmentFromType(t_type, t_dataLayout);
+    auto constSize = dyn_cast<ConstantInt>(t_size);
+    // operator new of a char or a bool returns the i8* which is used, so
+    // there is no bitcast with the type, but an object of a known size can
+    // never need more than its natural alignment
+    if (!t_type && constSize) {
+      alignment = rpools::getNaturalAlignment(constSize->getZExtValue());
+    }
+    // tiny allocations are made by custom_new, which has no size class for
+    // them
+    if (constSize &&
+        constSize->getZExtValue() <= rpools::CUSTOM_NEW_THRESHOLD &&
+        !rpools::isTinyAllocation(constSize->getZExtValue(), alignment)) {
+      size_t sizeClass = rpools::getSizeClass(constSize->getZExtValue(),
+                                              alignment);
+      if (t_shortLived) {
+        return { *OP_TO_CUSTOM_LIFETIME.at(t_name),
+                 { t_builder.getInt64(sizeClass),
+                   t_builder.getInt64(rpools::SHORT_LIVED) } };
+      }
+      uint64_t typeId = getTypeId(t_type);
+      if (typeId != 0) {
+        return { *OP_TO_CUSTOM_TYPED.at(t_name),
+                 { t_builder.getInt64(sizeClass),
+                   t_builder.getInt64(typeId) } };
+      }
+      return { *OP_TO_CUSTOM_CLASS.at(t_name),
+               { t_builder.getInt64(sizeClass) } };
+    }
+    return { *OP_TO_CUSTOM.at(t_name),
+             { t_size, t_builder.getInt64(alignment) } };
+  }
+
+  /**
+   *  @param t_ptr the pointer operand of the operator delete call
+   *  @param t_size the size operand of a sized operator delete, or nullptr
+   *  @param t_builder the builder which creates the arguments
+   *  @return the function which replaces operator delete and its arguments:
+   *          `custom_delete_sized(ptr, size, alignment)` if the size of the
+   *          object is known, `custom_delete(ptr)` otherwise.
+   */
+  static std::pair<Function*, vector<Value*>>
+  getCustomDelete(Value* t_ptr, Value* t_size, IRBuilder<>& t_builder) {
+    uint64_t size = 0;
+    size_t alignment = alignof(max_align_t);
+    if (getDeallocationSize(t_ptr, size, alignment)) {
+      return { CUSTOM_DELETE_SIZED_FUNC,
+               { t_ptr, t_builder.getInt64(size),
+                 t_builder.getInt64(alignment) } };
+    } else if (t_size) {
+      return { CUSTOM_DELETE_SIZED_FUNC,
+               { t_ptr, t_size, t_builder.getInt64(alignment) } };
+    }
+    return { CUSTOM_DELETE_FUNC, { t_ptr } };
+  }
+
+  /**
+   *  @param t_mod the module whose allocations were replaced
+   *  @return the number of calls of each size class in `t_mod`.
+   */
+  static vector<uint64_t> countSites(Module& t_mod) {
+    vector<uint64_t> sites(rpools::NUM_OF_SIZE_CLASSES, 0);
+    for (Function* func : { CUSTOM_NEW_CLASS_FUNC,
+                            CUSTOM_NEW_CLASS_NO_THROW_FUNC,
+                            CUSTOM_NEW_TYPED_FUNC,
+                            CUSTOM_NEW_TYPED_NO_THROW_FUNC }) {
+      for (User* user : func->users()) {
+        CallSite cs(user);
+        if (!cs) {
+          continue;
+        }
+        auto sizeClass = dyn_cast<ConstantInt>(cs.getArgument(0));
+        if (sizeClass && sizeClass->getZExtValue() < sites.size()) {
+          ++sites[sizeClass->getZExtValue()];
+        }
+      }
+    }
+    return sites;
+  }
+
+  /**
+   *  Adds the manifest of `t_mod` and a global constructor which
+   *  registers it to the runtime.
+   *  @param t_sites the number of calls of each size class
+   */
+  static void emitManifest(Module& t_mod, const vector<uint64_t>& t_sites) {
+    LLVMContext& context = t_mod.getContext();
+    Constant* table = ConstantDataArray::get(context, t_sites);
+    auto manifest = new GlobalVariable(t_mod, table->getType(), true,
+                                       GlobalValue::PrivateLinkage, table,
+                                       "custom_new_manifest");
+    // void custom_new_register_manifest(const size_t*, size_t)
+    Constant* registerManifest = t_mod.getOrInsertFunction(
+      REGISTER_MANIFEST_NAME,
+      FunctionType::get(Type::getVoidTy(context),
+                        { Type::getInt64PtrTy(context),
+                          Type::getInt64Ty(context) }, false));
+    Function* ctor = Function::Create(
+      FunctionType::get(Type::getVoidTy(context), false),
+      GlobalValue::InternalLinkage, "custom_new_manifest_ctor", &t_mod);
+    IRBuilder<> builder(BasicBlock::Create(context, "entry", ctor));
+    builder.CreateCall(registerManifest, {
+      builder.CreateConstInBoundsGEP2_64(manifest, 0, 0),
+      builder.getInt64(t_sites.size()) });
+    builder.CreateRetVoid();
+    // run before the constructors of the program, which might allocate
+    appendToGlobalCtors(t_mod, ctor, 101);
+  }
+
+  /**
+   *  Appends the sites of every size class which is used by `t_mod` to
+   *  `-custom-new-report`.
+   */
+  static void writeReport(Module& t_mod, const vector<uint64_t>& t_sites) {
+    std::error_code error;
+    raw_fd_ostream report(ReportFile, error, sys::fs::F_Append);
+    if (error) {
+      errs() << "custom-new-report: " << error.message() << "\n";
+      return;
+    }
+    for (size_t i = 0; i < t_sites.size(); ++i) {
+      if (t_sites[i] != 0) {
+        report << t_mod.getModuleIdentifier() << " "
+               << rpools::getClassSize(i) << " " << t_sites[i] << "\n";
+      }
     }
-    return alignment;
   }
 
   CustomNewDelete() : BasicBlockPass(ID) {}
@@ -76,20 +376,76 @@ struct CustomNewDelete : public BasicBlockPass {
     mod.getOrInsertFunction(CUSTOM_NEW_NO_THROW_NAME, customNewType);
     CUSTOM_NEW_NO_THROW_FUNC = mod.getFunction(CUSTOM_NEW_NO_THROW_NAME);
 
+    // custom_new_class type definition: void* custom_new_class(size_t)
+    FunctionType* customNewClassType = FunctionType::get(
+      Type::getInt8PtrTy(context),
+      { Type::getInt64Ty(context) },
+      false
+    );
+    mod.getOrInsertFunction(CUSTOM_NEW_CLASS_NAME, customNewClassType);
+    CUSTOM_NEW_CLASS_FUNC = mod.getFunction(CUSTOM_NEW_CLASS_NAME);
+    mod.getOrInsertFunction(CUSTOM_NEW_CLASS_NO_THROW_NAME,
+                            customNewClassType);
+    CUSTOM_NEW_CLASS_NO_THROW_FUNC =
+      mod.getFunction(CUSTOM_NEW_CLASS_NO_THROW_NAME);
+
+    // reuse customNewType because custom_new_typed takes two size_t as well
+    mod.getOrInsertFunction(CUSTOM_NEW_TYPED_NAME, customNewType);
+    CUSTOM_NEW_TYPED_FUNC = mod.getFunction(CUSTOM_NEW_TYPED_NAME);
+    mod.getOrInsertFunction(CUSTOM_NEW_TYPED_NO_THROW_NAME, customNewType);
+    CUSTOM_NEW_TYPED_NO_THROW_FUNC =
+      mod.getFunction(CUSTOM_NEW_TYPED_NO_THROW_NAME);
+
+    // custom_new_lifetime takes two size_t as well
+    mod.getOrInsertFunction(CUSTOM_NEW_LIFETIME_NAME, customNewType);
+    CUSTOM_NEW_LIFETIME_FUNC = mod.getFunction(CUSTOM_NEW_LIFETIME_NAME);
+    mod.getOrInsertFunction(CUSTOM_NEW_LIFETIME_NO_THROW_NAME,
+                            customNewType);
+    CUSTOM_NEW_LIFETIME_NO_THROW_FUNC =
+      mod.getFunction(CUSTOM_NEW_LIFETIME_NO_THROW_NAME);
+    readLifetimeProfile();
+
     // custom_delete type definition: void custom_delete(void*)
     FunctionType* customDeleteType = FunctionType::get(
-      Type::getInt8PtrTy(context),
-      { Type::getVoidTy(context) },
+      Type::getVoidTy(context),
+      { Type::getInt8PtrTy(context) },
       false
     );
     mod.getOrInsertFunction(CUSTOM_DELETE_NAME, customDeleteType);
     CUSTOM_DELETE_FUNC = mod.getFunction(CUSTOM_DELETE_NAME);
+
+    // custom_delete_sized type definition:
+    // void custom_delete_sized(void*, size_t, size_t)
+    FunctionType* customDeleteSizedType = FunctionType::get(
+      Type::getVoidTy(context),
+      { Type::getInt8PtrTy(context), Type::getInt64Ty(context),
+        Type::getInt64Ty(context) },
+      false
+    );
+    mod.getOrInsertFunction(CUSTOM_DELETE_SIZED_NAME, customDeleteSizedType);
+    CUSTOM_DELETE_SIZED_FUNC = mod.getFunction(CUSTOM_DELETE_SIZED_NAME);
+    return true;
+  }
+
+  using BasicBlockPass::doFinalization;
+  bool doFinalization(Module& mod) override {
+    vector<uint64_t> sites = countSites(mod);
+    if (!ReportFile.empty()) {
+      writeReport(mod, sites);
+    }
+    if (!EnableManifest ||
+        std::all_of(sites.begin(), sites.end(),
+                    [](uint64_t t_sites) { return t_sites == 0; })) {
+      return false;
+    }
+    emitManifest(mod, sites);
     return true;
   }
 
   bool runOnBasicBlock(BasicBlock& bb) override {
     Module* mod = bb.getModule();
     const DataLayout& dataLayout = mod->getDataLayout();
+    bool shortLived = isShortLived(*bb.getParent());
     // all calls to operator new/delete will be saved in this vector
     std::vector<Instruction*> insts;
     for (auto& inst : bb) {
@@ -100,14 +456,13 @@ struct CustomNewDelete : public BasicBlockPass {
           std::string name = getDemangledName(func->getName().str());
           IRBuilder<> builder(&ci);
           if (isNew(name)) {
-            // next inst might be a BitCast which holds the alignment of the
-            // type being allocated
-            size_t alignment = getAlignmentFromInst(inst.getNextNode(),
-                                                    dataLayout);
+            // next inst might be a BitCast which holds the type being
+            // allocated
+            Type* type = getTypeFromInst(inst.getNextNode());
+            auto customNew = getCustomNew(name, ci.getOperand(0), type,
+                                          dataLayout, shortLived, builder);
             CallInst* customNewCall =
-                builder.CreateCall(*OP_TO_CUSTOM.at(name),
-                                   { ci.getOperand(0),
-                                     builder.getInt64(alignment) });
+                builder.CreateCall(customNew.first, customNew.second);
             customNewCall->setAttributes(ci.getAttributes());
             // replace the call to operator new with custom_new
             // but make sure the first argument of operator new
@@ -115,12 +470,15 @@ struct CustomNewDelete : public BasicBlockPass {
             ci.replaceAllUsesWith(customNewCall);
             // save call instruction to remove it later
             insts.push_back(&ci);
-          } else if (isDelete(name)) {
-            // we are processing an operator delete call
-            // because custom_delete and operator delete take the same
-            // type and number of arguments, we can just change the
-            // function called (in this case call custom_delete)
-            ci.setCalledFunction(CUSTOM_DELETE_FUNC);
+          } else if (isDelete(name) || isSizedDelete(name)) {
+            // we are processing an operator delete call, which is replaced
+            // with custom_delete or with custom_delete_sized if the size
+            // of the object is known
+            auto customDelete = getCustomDelete(
+              ci.getArgOperand(0),
+              isSizedDelete(name) ? ci.getArgOperand(1) : nullptr, builder);
+            builder.CreateCall(customDelete.first, customDelete.second);
+            insts.push_back(&ci);
           }
         }
       } else if (isa<InvokeInst>(inst)) {
@@ -132,21 +490,26 @@ struct CustomNewDelete : public BasicBlockPass {
             if (isNew(name)) {
               // InvokeInsts seem to hold the BitCastInst which contains the
               // type being allocated in the NormalDest BasicBlock
-              size_t alignment =
-                getAlignmentFromInst(&ii.getNormalDest()->front(),
-                                     dataLayout);
+              Type* type = getTypeFromInst(&ii.getNormalDest()->front());
+              auto customNew = getCustomNew(name, ii.getOperand(0), type,
+                                            dataLayout, shortLived, builder);
               InvokeInst* customNewInvoke =
-                builder.CreateInvoke(*OP_TO_CUSTOM.at(name),
+                builder.CreateInvoke(customNew.first,
 				     ii.getNormalDest(),
 				     ii.getUnwindDest(),
-				     { ii.getOperand(0),
-				       builder.getInt64(alignment) }
+				     customNew.second
 	      );
               customNewInvoke->setAttributes(ii.getAttributes());
               ii.replaceAllUsesWith(customNewInvoke);
               insts.push_back(&ii);
-            } else if (isDelete(name)) {
-              ii.setCalledFunction(CUSTOM_DELETE_FUNC);
+            } else if (isDelete(name) || isSizedDelete(name)) {
+              auto customDelete = getCustomDelete(
+                ii.getArgOperand(0),
+                isSizedDelete(name) ? ii.getArgOperand(1) : nullptr,
+                builder);
+              builder.CreateInvoke(customDelete.first, ii.getNormalDest(),
+                                   ii.getUnwindDest(), customDelete.second);
+              insts.push_back(&ii);
           }
         }
       }
@@ -162,14 +525,37 @@ struct CustomNewDelete : public BasicBlockPass {
 }  // end of anonymous namespace
 
 char CustomNewDelete::ID = 0;
-const StringRef CustomNewDelete::CUSTOM_NEW_NAME = "_Z10custom_newmm";
+const StringRef CustomNewDelete::CUSTOM_NEW_NAME = CUSTOM_NEW_MANGLED;
 const StringRef CustomNewDelete::CUSTOM_NEW_NO_THROW_NAME =
   "_Z19custom_new_no_throwmm";
-const StringRef CustomNewDelete::CUSTOM_DELETE_NAME = "_Z13custom_deletePv";
+const StringRef CustomNewDelete::CUSTOM_NEW_CLASS_NAME =
+  CUSTOM_NEW_CLASS_MANGLED;
+const StringRef CustomNewDelete::CUSTOM_NEW_CLASS_NO_THROW_NAME =
+  "_Z25custom_new_class_no_throwm";
+const StringRef CustomNewDelete::CUSTOM_NEW_TYPED_NAME =
+  "_Z16custom_new_typedmm";
+const StringRef CustomNewDelete::CUSTOM_NEW_TYPED_NO_THROW_NAME =
+  "_Z25custom_new_typed_no_throwmm";
+const StringRef CustomNewDelete::CUSTOM_NEW_LIFETIME_NAME =
+  CUSTOM_NEW_LIFETIME_MANGLED;
+const StringRef CustomNewDelete::CUSTOM_NEW_LIFETIME_NO_THROW_NAME =
+  "_Z28custom_new_lifetime_no_throwmm";
+const StringRef CustomNewDelete::CUSTOM_DELETE_NAME = CUSTOM_DELETE_MANGLED;
+const StringRef CustomNewDelete::CUSTOM_DELETE_SIZED_NAME =
+  CUSTOM_DELETE_SIZED_MANGLED;
+const StringRef CustomNewDelete::REGISTER_MANIFEST_NAME =
+  "_Z28custom_new_register_manifestPKmm";
 
 Function* CustomNewDelete::CUSTOM_NEW_FUNC = nullptr;
 Function* CustomNewDelete::CUSTOM_NEW_NO_THROW_FUNC = nullptr;
+Function* CustomNewDelete::CUSTOM_NEW_CLASS_FUNC = nullptr;
+Function* CustomNewDelete::CUSTOM_NEW_CLASS_NO_THROW_FUNC = nullptr;
+Function* CustomNewDelete::CUSTOM_NEW_TYPED_FUNC = nullptr;
+Function* CustomNewDelete::CUSTOM_NEW_TYPED_NO_THROW_FUNC = nullptr;
+Function* CustomNewDelete::CUSTOM_NEW_LIFETIME_FUNC = nullptr;
+Function* CustomNewDelete::CUSTOM_NEW_LIFETIME_NO_THROW_FUNC = nullptr;
 Function* CustomNewDelete::CUSTOM_DELETE_FUNC = nullptr;
+Function* CustomNewDelete::CUSTOM_DELETE_SIZED_FUNC = nullptr;
 
 const map<StringRef, Function**> CustomNewDelete::OP_TO_CUSTOM = {
   { NEW_OPS[0], &CUSTOM_NEW_FUNC },
@@ -178,6 +564,29 @@ const map<StringRef, Function**> CustomNewDelete::OP_TO_CUSTOM = {
   { NEW_NO_THROW_OPS[1], &CUSTOM_NEW_NO_THROW_FUNC }
 };
 
+const map<StringRef, Function**> CustomNewDelete::OP_TO_CUSTOM_CLASS = {
+  { NEW_OPS[0], &CUSTOM_NEW_CLASS_FUNC },
+  { NEW_OPS[1], &CUSTOM_NEW_CLASS_FUNC },
+  { NEW_NO_THROW_OPS[0], &CUSTOM_NEW_CLASS_NO_THROW_FUNC },
+  { NEW_NO_THROW_OPS[1], &CUSTOM_NEW_CLASS_NO_THROW_FUNC }
+};
+
+const map<StringRef, Function**> CustomNewDelete::OP_TO_CUSTOM_TYPED = {
+  { NEW_OPS[0], &CUSTOM_NEW_TYPED_FUNC },
+  { NEW_OPS[1], &CUSTOM_NEW_TYPED_FUNC },
+  { NEW_NO_THROW_OPS[0], &CUSTOM_NEW_TYPED_NO_THROW_FUNC },
+  { NEW_NO_THROW_OPS[1], &CUSTOM_NEW_TYPED_NO_THROW_FUNC }
+};
+
+const map<StringRef, Function**> CustomNewDelete::OP_TO_CUSTOM_LIFETIME = {
+  { NEW_OPS[0], &CUSTOM_NEW_LIFETIME_FUNC },
+  { NEW_OPS[1], &CUSTOM_NEW_LIFETIME_FUNC },
+  { NEW_NO_THROW_OPS[0], &CUSTOM_NEW_LIFETIME_NO_THROW_FUNC },
+  { NEW_NO_THROW_OPS[1], &CUSTOM_NEW_LIFETIME_NO_THROW_FUNC }
+};
+
+std::set<std::string> CustomNewDelete::SHORT_LIVED_FUNCS;
+
 static RegisterPass<CustomNewDelete> X("custom new delete",
                                        "CustomNewDelete Pass",
                                        false /* Only looks at CFG */,
@@ -0,0 +1,116 @@
+#include <llvm/Pass.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#include <vector>
+
+#include "common.hpp"
+
+using namespace llvm;
+using namespace legacy;
+using namespace custom_pass;
+using std::vector;
+
+static cl::opt<unsigned> MaxAllocationSize(
+  "h2s-max-size", cl::init(256),
+  cl::desc("The largest allocation that is moved to the stack (in bytes)"));
+
+static cl::opt<unsigned> MaxFrameSize(
+  "h2s-max-frame", cl::init(1024),
+  cl::desc("The number of bytes that can be moved to the stack of a single "
+           "function"));
+
+namespace {
+/**
+ *  Replaces allocations which never escape the function in which they are
+ *  made with stack allocations, and removes their deallocations.
+ *  @par
+ *  An allocation is moved to the stack when:
+ *  * its size is a constant which is at most `-h2s-max-size` bytes
+ *  * it is not made inside of a loop, so that the stack slot cannot be
+ *    reused while the object is alive
+ *  * the pointer never escapes (@see custom_pass::doesNotEscape), therefore
+ *    the object cannot be used after the function returns
+ *  @note Both operator new and the `custom_new` functions inserted by the
+ *        `CustomNewDelete` pass are considered. The pass runs after the
+ *        inliner, when most constructors have been inlined.
+ */
+struct HeapToStack : public FunctionPass {
+  static char ID;
+
+  HeapToStack() : FunctionPass(ID) {}
+
+  void getAnalysisUsage(AnalysisUsage& au) const override {
+    au.addRequired<LoopInfoWrapperPass>();
+  }
+
+  bool runOnFunction(Function& func) override {
+    if (func.isDeclaration()) {
+      return false;
+    }
+    LoopInfo& loopInfo = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    // all allocations which can be moved to the stack
+    vector<std::pair<Instruction*, uint64_t>> allocs;
+    uint64_t frameSize = 0;
+    for (auto& bb : func) {
+      if (loopInfo.getLoopFor(&bb)) {
+        continue;
+      }
+      for (auto& inst : bb) {
+        CallSite cs(&inst);
+        uint64_t size = 0;
+        if (!cs || !isAllocation(getCalledName(cs)) ||
+            !getAllocationSize(cs, size) || size == 0 ||
+            size > MaxAllocationSize ||
+            frameSize + size > MaxFrameSize) {
+          continue;
+        }
+        vector<Instruction*> deletes;
+        if (doesNotEscape(&inst, deletes)) {
+          allocs.push_back({ &inst, size });
+          frameSize += size;
+        }
+      }
+    }
+    if (allocs.empty()) {
+      return false;
+    }
+    // allocas in the entry block are part of the stack frame
+    BasicBlock& entry = func.getEntryBlock();
+    IRBuilder<> builder(&entry, entry.getFirstInsertionPt());
+    for (auto& alloc : allocs) {
+      AllocaInst* slot = builder.CreateAlloca(builder.getInt8Ty(),
+                                              builder.getInt64(alloc.second));
+      slot->setAlignment(alignof(max_align_t));
+      vector<Instruction*> deletes;
+      doesNotEscape(alloc.first, deletes);
+      for (auto del : deletes) {
+        eraseCall(del);
+      }
+      alloc.first->replaceAllUsesWith(slot);
+      eraseCall(alloc.first);
+    }
+    return true;
+  }
+}; // end of struct HeapToStack
+}  // end of anonymous namespace
+
+char HeapToStack::ID = 0;
+
+static RegisterPass<HeapToStack> X("heap-to-stack",
+                                   "HeapToStack Pass",
+                                   false /* Only looks at CFG */,
+                                   false /* Analysis Pass */);
+
+static void registerMyPass(const PassManagerBuilder &,
+                           PassManagerBase &PM) {
+  PM.add(new HeapToStack());
+}
+static RegisterStandardPasses
+RegisterMyPass(PassManagerBuilder::EP_ScalarOptimizerLate,
+               registerMyPass);
@@ -0,0 +1,191 @@
+#include <llvm/Pass.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#include <vector>
+
+#include "common.hpp"
+
+using namespace llvm;
+using namespace legacy;
+using namespace custom_pass;
+using std::vector;
+
+namespace {
+/**
+ *  Hoists allocations that are made and deallocated in every iteration of a
+ *  loop out of the loop, so that a single slot is reused by all iterations.
+ *  The allocation is made in the preheader of the loop and deallocated in
+ *  each of its exit blocks.
+ *  @par
+ *  An allocation is hoisted when:
+ *  * it is a call (not an invoke) whose size is a constant
+ *  * it is made in the loop itself, not in one of its subloops
+ *  * it never escapes its function (@see custom_pass::doesNotEscape) and it
+ *    is deallocated exactly once, by a call in the same loop, whose other
+ *    arguments are constants
+ *  * the deallocation is executed before the next iteration starts: its
+ *    block is dominated by the block of the allocation and dominates every
+ *    latch of the loop
+ *  * the loop cannot be left between the allocation and the deallocation,
+ *    and it cannot return
+ *  @note The pass runs before `HeapToStack`, which can move the hoisted
+ *        allocations to the stack.
+ */
+struct LoopAllocReuse : public FunctionPass {
+  static char ID;
+
+  LoopAllocReuse() : FunctionPass(ID) {}
+
+  void getAnalysisUsage(AnalysisUsage& au) const override {
+    au.addRequired<LoopInfoWrapperPass>();
+    au.addRequired<DominatorTreeWrapperPass>();
+    au.addPreserved<LoopInfoWrapperPass>();
+    au.addPreserved<DominatorTreeWrapperPass>();
+  }
+
+  /**
+   *  @param t_loop the loop in which `t_alloc` is made
+   *  @param t_alloc an instruction of `t_loop`
+   *  @param t_dealloc set to the deallocation of `t_alloc`
+   *  @return whether `t_alloc` is an allocation which can be hoisted.
+   */
+  static bool isCandidate(Loop& t_loop, Instruction& t_alloc,
+                          const LoopInfo& t_loopInfo,
+                          const DominatorTree& t_domTree,
+                          CallInst*& t_dealloc) {
+    auto ci = dyn_cast<CallInst>(&t_alloc);
+    uint64_t size = 0;
+    if (!ci || !isAllocation(getCalledName(CallSite(ci))) ||
+        !getAllocationSize(CallSite(ci), size)) {
+      return false;
+    }
+    vector<Instruction*> deletes;
+    if (!doesNotEscape(ci, deletes) || deletes.size() != 1) {
+      return false;
+    }
+    t_dealloc = dyn_cast<CallInst>(deletes[0]);
+    if (!t_dealloc ||
+        t_loopInfo.getLoopFor(t_dealloc->getParent()) != &t_loop) {
+      return false;
+    }
+    // the deallocation is copied to the exit blocks of the loop
+    for (unsigned i = 1; i < t_dealloc->getNumArgOperands(); ++i) {
+      if (!isa<Constant>(t_dealloc->getArgOperand(i))) {
+        return false;
+      }
+    }
+    BasicBlock* allocBB = ci->getParent();
+    BasicBlock* deallocBB = t_dealloc->getParent();
+    if (!t_domTree.dominates(ci, t_dealloc)) {
+      return false;
+    }
+    // every iteration which allocates also deallocates
+    SmallVector<BasicBlock*, 4> latches;
+    t_loop.getLoopLatches(latches);
+    for (auto latch : latches) {
+      if (!t_domTree.dominates(deallocBB, latch)) {
+        return false;
+      }
+    }
+    // the loop is either left before the allocation or after the
+    // deallocation
+    SmallVector<BasicBlock*, 4> exiting;
+    t_loop.getExitingBlocks(exiting);
+    for (auto block : exiting) {
+      bool beforeAlloc = block != allocBB &&
+        t_domTree.dominates(block, allocBB);
+      bool afterDealloc = t_domTree.dominates(deallocBB, block);
+      if (!beforeAlloc && !afterDealloc) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   *  Hoists the allocations of `t_loop` which can be reused by all of its
+   *  iterations, and the allocations of its subloops.
+   */
+  bool runOnLoop(Loop& t_loop, const LoopInfo& t_loopInfo,
+                 const DominatorTree& t_domTree) {
+    bool changed = false;
+    for (auto subLoop : t_loop.getSubLoops()) {
+      changed |= runOnLoop(*subLoop, t_loopInfo, t_domTree);
+    }
+    BasicBlock* preheader = t_loop.getLoopPreheader();
+    if (!preheader || !t_loop.hasDedicatedExits()) {
+      return changed;
+    }
+    for (auto bb : t_loop.blocks()) {
+      // the hoisted allocations would leak
+      if (isa<ReturnInst>(bb->getTerminator())) {
+        return changed;
+      }
+    }
+    vector<std::pair<CallInst*, CallInst*>> candidates;
+    for (auto bb : t_loop.blocks()) {
+      if (t_loopInfo.getLoopFor(bb) != &t_loop) {
+        continue;
+      }
+      for (auto& inst : *bb) {
+        CallInst* dealloc = nullptr;
+        if (isCandidate(t_loop, inst, t_loopInfo, t_domTree, dealloc)) {
+          candidates.push_back({ cast<CallInst>(&inst), dealloc });
+        }
+      }
+    }
+    SmallVector<BasicBlock*, 4> exits;
+    t_loop.getUniqueExitBlocks(exits);
+    for (auto& candidate : candidates) {
+      CallInst* alloc = candidate.first;
+      CallInst* dealloc = candidate.second;
+      alloc->moveBefore(preheader->getTerminator());
+      for (auto exit : exits) {
+        auto exitDealloc = cast<CallInst>(dealloc->clone());
+        exitDealloc->insertBefore(&*exit->getFirstInsertionPt());
+        IRBuilder<> builder(exitDealloc);
+        exitDealloc->setArgOperand(0, builder.CreatePointerCast(
+          alloc, dealloc->getArgOperand(0)->getType()));
+      }
+      dealloc->eraseFromParent();
+      changed = true;
+    }
+    return changed;
+  }
+
+  bool runOnFunction(Function& func) override {
+    if (func.isDeclaration()) {
+      return false;
+    }
+    LoopInfo& loopInfo = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    DominatorTree& domTree =
+      getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    bool changed = false;
+    for (auto loop : loopInfo) {
+      changed |= runOnLoop(*loop, loopInfo, domTree);
+    }
+    return changed;
+  }
+}; // end of struct LoopAllocReuse
+}  // end of anonymous namespace
+
+char LoopAllocReuse::ID = 0;
+
+static RegisterPass<LoopAllocReuse> X("loop-alloc-reuse",
+                                      "LoopAllocReuse Pass",
+                                      false /* Only looks at CFG */,
+                                      false /* Analysis Pass */);
+
+static void registerMyPass(const PassManagerBuilder &,
+                           PassManagerBase &PM) {
+  PM.add(new LoopAllocReuse());
+}
+static RegisterStandardPasses
+RegisterMyPass(PassManagerBuilder::EP_LoopOptimizerEnd,
+               registerMyPass);
@@ -1,7 +1,12 @@
 #include <cxxabi.h>
 #include <algorithm>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
 
 #include "common.hpp"
+#include "rpools/custom_new/size_classes.hpp"
 
 using namespace custom_pass;
 using namespace llvm;
@@ -20,6 +25,125 @@ bool custom_pass::isDelete(const string& t_name) {
       != DELETE_NO_THROW_OPS.end();
 }
 
+static bool contains(const std::vector<string>& t_names,
+                     const string& t_name) {
+  return find(t_names.begin(), t_names.end(), t_name) != t_names.end();
+}
+
+bool custom_pass::isSizedDelete(const string& t_name) {
+  return contains(SIZED_DELETE_OPS, t_name);
+}
+
+bool custom_pass::isAllocation(const string& t_name) {
+  return isNew(t_name) || contains(CUSTOM_NEW_OPS, t_name)
+    || contains(CUSTOM_NEW_CLASS_OPS, t_name);
+}
+
+bool custom_pass::isDeallocation(const string& t_name) {
+  return isDelete(t_name) || isSizedDelete(t_name)
+    || contains(CUSTOM_DELETE_OPS, t_name);
+}
+
+string custom_pass::getCalledName(CallSite t_cs) {
+  Function* func = t_cs.getCalledFunction();
+  return func ? getDemangledName(func->getName().str()) : "";
+}
+
+bool custom_pass::getAllocationSize(CallSite t_cs, uint64_t& t_size) {
+  auto constSize = dyn_cast<ConstantInt>(t_cs.getArgument(0));
+  if (!constSize) {
+    return false;
+  }
+  t_size = constSize->getZExtValue();
+  // custom_new_class receives the size class instead of the size
+  if (contains(CUSTOM_NEW_CLASS_OPS, getCalledName(t_cs))) {
+    t_size = rpools::getClassSize(t_size);
+  }
+  return true;
+}
+
+size_t custom_pass::getAllocationAlignment(CallSite t_cs) {
+  string name = getCalledName(t_cs);
+  if (contains(CUSTOM_NEW_CLASS_OPS, name)) {
+    if (auto sizeClass = dyn_cast<ConstantInt>(t_cs.getArgument(0))) {
+      return rpools::getClassAlignment(sizeClass->getZExtValue());
+    }
+  } else if (contains(CUSTOM_NEW_OPS, name)) {
+    if (auto alignment = dyn_cast<ConstantInt>(t_cs.getArgument(1))) {
+      return alignment->getZExtValue();
+    }
+  }
+  // operator new returns memory that is suitably aligned for any object
+  return alignof(std::max_align_t);
+}
+
+bool custom_pass::getDeallocationSize(Value* t_ptr, uint64_t& t_size,
+                                      size_t& t_alignment) {
+  CallSite cs(t_ptr->stripPointerCasts());
+  if (!cs || !isAllocation(getCalledName(cs)) ||
+      !getAllocationSize(cs, t_size)) {
+    return false;
+  }
+  t_alignment = getAllocationAlignment(cs);
+  return true;
+}
+
+bool custom_pass::doesNotEscape(Instruction* t_alloc,
+                                std::vector<Instruction*>& t_deletes) {
+  // the allocation and the pointers derived from it
+  SmallVector<Value*, 8> worklist = { t_alloc };
+  SmallPtrSet<Value*, 8> visited;
+  while (!worklist.empty()) {
+    Value* value = worklist.pop_back_val();
+    if (!visited.insert(value).second) {
+      continue;
+    }
+    for (User* user : value->users()) {
+      auto inst = dyn_cast<Instruction>(user);
+      if (!inst) {
+        return false;
+      }
+      if (isa<BitCastInst>(inst) || isa<GetElementPtrInst>(inst)) {
+        worklist.push_back(inst);
+      } else if (isa<LoadInst>(inst) || isa<ICmpInst>(inst)) {
+        continue;
+      } else if (auto si = dyn_cast<StoreInst>(inst)) {
+        // storing the pointer itself somewhere makes it escape
+        if (si->getValueOperand() == value) {
+          return false;
+        }
+      } else if (CallSite cs = CallSite(inst)) {
+        if (isDeallocation(getCalledName(cs))) {
+          // only the start of the allocation can be deallocated
+          if (isa<GetElementPtrInst>(value)) {
+            return false;
+          }
+          t_deletes.push_back(inst);
+          continue;
+        }
+        for (unsigned i = 0; i < cs.getNumArgOperands(); ++i) {
+          if (cs.getArgument(i) == value && !cs.doesNotCapture(i)) {
+            return false;
+          }
+        }
+      } else {
+        // phis, selects, returns, ptrtoint, etc.
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void custom_pass::eraseCall(Instruction* t_inst) {
+  if (auto ii = dyn_cast<InvokeInst>(t_inst)) {
+    // the call cannot throw anymore
+    ii->getUnwindDest()->removePredecessor(ii->getParent());
+    BranchInst::Create(ii->getNormalDest(), ii);
+  }
+  t_inst->eraseFromParent();
+}
+
 std::string custom_pass::getDemangledName(const string& t_name) {
   int status = -1;
   char* demangledName = abi::__cxa_demangle(
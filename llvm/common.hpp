@@ -6,6 +6,8 @@
 #include <llvm/ADT/StringRef.h>
 #include <llvm/IR/DataLayout.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/CallSite.h>
+#include <llvm/IR/Instruction.h>
 
 namespace custom_pass {
 
@@ -25,6 +27,39 @@ const std::vector<std::string> DELETE_NO_THROW_OPS = {
   "operator delete(void*, std::nothrow_t const&)",
   "operator delete[](void*, std::nothrow_t const&)"
 };
+const std::vector<std::string> SIZED_DELETE_OPS = {
+  "operator delete(void*, unsigned long)",
+  "operator delete[](void*, unsigned long)"
+};
+
+const std::vector<std::string> CUSTOM_NEW_OPS = {
+  "custom_new(unsigned long, unsigned long)",
+  "custom_new_no_throw(unsigned long, unsigned long)"
+};
+/** The allocation functions whose first argument is a size class. */
+const std::vector<std::string> CUSTOM_NEW_CLASS_OPS = {
+  "custom_new_class(unsigned long)",
+  "custom_new_class_no_throw(unsigned long)",
+  "custom_new_typed(unsigned long, unsigned long)",
+  "custom_new_typed_no_throw(unsigned long, unsigned long)",
+  "custom_new_lifetime(unsigned long, unsigned long)",
+  "custom_new_lifetime_no_throw(unsigned long, unsigned long)"
+};
+const std::vector<std::string> CUSTOM_DELETE_OPS = {
+  "custom_delete(void*)",
+  "custom_delete_sized(void*, unsigned long, unsigned long)"
+};
+
+/** Mangled custom_new function name. */
+const std::string CUSTOM_NEW_MANGLED = "_Z10custom_newmm";
+/** Mangled custom_new_class function name. */
+const std::string CUSTOM_NEW_CLASS_MANGLED = "_Z16custom_new_classm";
+/** Mangled custom_new_lifetime function name. */
+const std::string CUSTOM_NEW_LIFETIME_MANGLED = "_Z19custom_new_lifetimemm";
+/** Mangled custom_delete function name. */
+const std::string CUSTOM_DELETE_MANGLED = "_Z13custom_deletePv";
+/** Mangled custom_delete_sized function name. */
+const std::string CUSTOM_DELETE_SIZED_MANGLED = "_Z19custom_delete_sizedPvmm";
 
 /**
  *  @param t_name a demangled Function name
@@ -38,6 +73,74 @@ bool isNew(const std::string& t_name);
  */
 bool isDelete(const std::string& t_name);
 
+/**
+ *  @param t_name a demangled Function name
+ *  @return whether `t_name` is in `SIZED_DELETE_OPS`.
+ */
+bool isSizedDelete(const std::string& t_name);
+
+/**
+ *  @param t_name a demangled Function name
+ *  @return whether `t_name` is an operator new or one of the `custom_new`
+ *          functions.
+ */
+bool isAllocation(const std::string& t_name);
+
+/**
+ *  @param t_name a demangled Function name
+ *  @return whether `t_name` is an operator delete or one of the
+ *          `custom_delete` functions.
+ */
+bool isDeallocation(const std::string& t_name);
+
+/**
+ *  @param t_cs a call site
+ *  @return the demangled name of the function called by `t_cs`, or an empty
+ *          string if the call is indirect.
+ */
+std::string getCalledName(llvm::CallSite t_cs);
+
+/**
+ *  @param t_cs a call to an allocation function (@see isAllocation)
+ *  @param t_size set to the number of bytes which are allocated
+ *  @return whether the number of bytes allocated by `t_cs` is a constant.
+ */
+bool getAllocationSize(llvm::CallSite t_cs, uint64_t& t_size);
+
+/**
+ *  @param t_cs a call to an allocation function (@see isAllocation)
+ *  @return the alignment of the memory allocated by `t_cs`.
+ */
+size_t getAllocationAlignment(llvm::CallSite t_cs);
+
+/**
+ *  @param t_ptr a pointer which is deallocated
+ *  @param t_size set to the number of bytes which were allocated
+ *  @param t_alignment set to the alignment of the allocation
+ *  @return whether `t_ptr` is (a cast of) the result of an allocation of a
+ *          constant size.
+ */
+bool getDeallocationSize(llvm::Value* t_ptr, uint64_t& t_size,
+                         size_t& t_alignment);
+
+/**
+ *  Checks whether the memory returned by an allocation never escapes the
+ *  function in which it is allocated: it is only loaded from, stored to,
+ *  compared, passed to `nocapture` arguments and deallocated.
+ *  @param t_alloc a call to an allocation function
+ *  @param t_deletes set to the calls which deallocate `t_alloc`
+ *  @return whether `t_alloc` does not escape.
+ */
+bool doesNotEscape(llvm::Instruction* t_alloc,
+                   std::vector<llvm::Instruction*>& t_deletes);
+
+/**
+ *  Erases a call or an invoke. An invoke is replaced with a branch to its
+ *  normal destination.
+ *  @param t_inst the call or invoke which is erased
+ */
+void eraseCall(llvm::Instruction* t_inst);
+
 /**
  *  @param t_name a demangled Function name
  *  @return the demangled name of a LLVM function.
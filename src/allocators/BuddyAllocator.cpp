@@ -0,0 +1,124 @@
+#include "rpools/allocators/BuddyAllocator.hpp"
+
+using namespace rpools;
+
+/**
+ *  @return the log2 of the smallest power of 2 which is at least `t_value`.
+ */
+static size_t ceilLog2(size_t t_value) {
+    size_t log2 = 0;
+    while ((size_t(1) << log2) < t_value) {
+        ++log2;
+    }
+    return log2;
+}
+
+BuddyAllocator::BuddyAllocator(size_t t_regionSize, size_t t_minBlockSize)
+    : m_minBlockLog2(ceilLog2(t_minBlockSize < sizeof(FreeBlock) ?
+                              sizeof(FreeBlock) : t_minBlockSize)) {
+    m_minBlockSize = size_t(1) << m_minBlockLog2;
+    size_t regionLog2 = ceilLog2(t_regionSize);
+    m_maxOrder = regionLog2 > m_minBlockLog2 ?
+        regionLog2 - m_minBlockLog2 : 0;
+    size_t regionSize = getRegionSize();
+    size_t pageSize = getPageSize();
+    m_region = static_cast<char*>(allocatePages(
+        (regionSize + pageSize - 1) / pageSize));
+    m_freeLists.assign(m_maxOrder + 1, nullptr);
+    // order k has 2^(maxOrder - k) blocks
+    size_t bits = 0;
+    for (size_t order = 0; order <= m_maxOrder; ++order) {
+        m_bitOffsets.push_back(bits);
+        bits += size_t(1) << (m_maxOrder - order);
+    }
+    m_freeBits.assign((bits + 63) / 64, 0);
+    m_orders.assign(size_t(1) << m_maxOrder, 0);
+    m_freeBytes = 0;
+    if (m_region) {
+        pushFree(m_region, m_maxOrder);
+        m_freeBytes = regionSize;
+    }
+}
+
+BuddyAllocator::~BuddyAllocator() {
+    freePages(m_region);
+}
+
+void* BuddyAllocator::allocate(size_t t_size) {
+    // ceilLog2 cannot handle sizes above 2^63
+    if (t_size > getRegionSize()) {
+        return nullptr;
+    }
+    size_t log2 = ceilLog2(t_size);
+    size_t order = log2 > m_minBlockLog2 ? log2 - m_minBlockLog2 : 0;
+    // find the smallest free block which is large enough
+    size_t freeOrder = order;
+    while (freeOrder <= m_maxOrder && !m_freeLists[freeOrder]) {
+        ++freeOrder;
+    }
+    if (freeOrder > m_maxOrder) {
+        return nullptr;
+    }
+    auto block = reinterpret_cast<char*>(m_freeLists[freeOrder]);
+    removeFree(block, freeOrder);
+    // split it until it has the requested order, the upper halves are free
+    while (freeOrder > order) {
+        --freeOrder;
+        pushFree(block + (m_minBlockSize << freeOrder), freeOrder);
+    }
+    m_orders[(block - m_region) >> m_minBlockLog2] = order;
+    m_freeBytes -= m_minBlockSize << order;
+    return block;
+}
+
+void BuddyAllocator::deallocate(void* t_ptr) {
+    if (!t_ptr) {
+        return;
+    }
+    auto block = static_cast<char*>(t_ptr);
+    size_t order = m_orders[(block - m_region) >> m_minBlockLog2];
+    m_freeBytes += m_minBlockSize << order;
+    // merge with the buddy as long as it is free
+    while (order < m_maxOrder) {
+        size_t offset = block - m_region;
+        char* buddy = m_region + (offset ^ (m_minBlockSize << order));
+        if (!isFree(buddy, order)) {
+            break;
+        }
+        removeFree(buddy, order);
+        block = buddy < block ? buddy : block;
+        ++order;
+    }
+    pushFree(block, order);
+}
+
+size_t BuddyAllocator::getBlockSize(const void* t_ptr) const {
+    auto block = static_cast<const char*>(t_ptr);
+    return m_minBlockSize << m_orders[(block - m_region) >> m_minBlockLog2];
+}
+
+void BuddyAllocator::pushFree(char* t_block, size_t t_order) {
+    auto freeBlock = reinterpret_cast<FreeBlock*>(t_block);
+    freeBlock->prev = nullptr;
+    freeBlock->next = m_freeLists[t_order];
+    if (freeBlock->next) {
+        freeBlock->next->prev = freeBlock;
+    }
+    m_freeLists[t_order] = freeBlock;
+    size_t bit = getBit(t_block, t_order);
+    m_freeBits[bit / 64] |= uint64_t(1) << (bit % 64);
+}
+
+void BuddyAllocator::removeFree(char* t_block, size_t t_order) {
+    auto freeBlock = reinterpret_cast<FreeBlock*>(t_block);
+    if (freeBlock->prev) {
+        freeBlock->prev->next = freeBlock->next;
+    } else {
+        m_freeLists[t_order] = freeBlock->next;
+    }
+    if (freeBlock->next) {
+        freeBlock->next->prev = freeBlock->prev;
+    }
+    size_t bit = getBit(t_block, t_order);
+    m_freeBits[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+}
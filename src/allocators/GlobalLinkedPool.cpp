@@ -1,31 +1,46 @@
 #include <cstdlib>
 #include <new>
 #include <cstring>
+#include <string>
 
 #include "rpools/allocators/GlobalLinkedPool.hpp"
 
 using namespace rpools;
 
 GlobalLinkedPool::GlobalLinkedPool(size_t t_sizeOfObjects,
-                                   size_t t_alignment)
+                                   size_t t_alignment,
+                                   bool t_trackOccupancy)
     : m_freePools(),
       m_poolLock(),
       m_sizeOfObjects(t_sizeOfObjects < sizeof(Node) ?
                       sizeof(Node) : t_sizeOfObjects),
-      m_slotSize(m_sizeOfObjects) {
+      m_slotSize(m_sizeOfObjects),
+      m_trackOccupancy(t_trackOccupancy) {
     avl_init(&m_freePools, nullptr);
-    // make sure the first slot starts at a proper alignment
-    size_t diff = mod(sizeof(PoolHeaderG), t_alignment);
-    if (diff != 0) {
-        m_headerPadding += t_alignment - diff;
-    }
     // make sure that slots are properly aligned
-    diff = mod(m_slotSize, t_alignment);
+    size_t diff = mod(m_slotSize, t_alignment);
     if (diff != 0) {
         m_slotSize += t_alignment - diff;
     }
-    m_poolSize = (getPageSize() - sizeof(PoolHeaderG) - m_headerPadding) /
-        m_slotSize;
+    size_t pageSize = getPageSize();
+    m_poolSize = (pageSize - sizeof(PoolHeaderG)) / m_slotSize;
+    // the bitmap of the page takes the space of some slots
+    for (;; --m_poolSize) {
+        m_headerPadding = m_trackOccupancy ?
+            OccupancyMap::getWords(m_poolSize) * sizeof(uint64_t) : 0;
+        // make sure the first slot starts at a proper alignment
+        diff = mod(sizeof(PoolHeaderG) + m_headerPadding, t_alignment);
+        if (diff != 0) {
+            m_headerPadding += t_alignment - diff;
+        }
+        if (sizeof(PoolHeaderG) + m_headerPadding + m_poolSize * m_slotSize <=
+            pageSize) {
+            break;
+        }
+    }
+    if (m_trackOccupancy) {
+        m_occupancy = OccupancyMap(m_slotSize, m_poolSize);
+    }
 }
 
 void* GlobalLinkedPool::allocate() {
@@ -38,17 +53,29 @@ void* GlobalLinkedPool::allocate() {
             return nextFree(pool);
         } else {
             // create a new pool because there are no free pool slots left
-            size_t pageSize = getPageSize();
-            Pool pool = aligned_alloc(pageSize, pageSize);
-            std::memset(pool, 0, pageSize);
-            constructPoolHeader(reinterpret_cast<char*>(pool));
-            pool_insert(&m_freePools, pool);
-            m_freePool = pool;
-            return nextFree(pool);
+            return nextFree(createPool());
         }
     }
 }
 
+void GlobalLinkedPool::reserve(size_t t_pools) {
+    m_poolLock.lock();
+    for (size_t pools = pool_count(&m_freePools); pools < t_pools; ++pools) {
+        createPool();
+    }
+    m_poolLock.unlock();
+}
+
+Pool GlobalLinkedPool::createPool() {
+    size_t pageSize = getPageSize();
+    Pool pool = allocatePages(1);
+    std::memset(pool, 0, pageSize);
+    constructPoolHeader(reinterpret_cast<char*>(pool));
+    pool_insert(&m_freePools, pool);
+    m_freePool = pool;
+    return pool;
+}
+
 void GlobalLinkedPool::deallocate(void* t_ptr) {
     // get the pool of ptr
     auto pool = reinterpret_cast<PoolHeaderG*>(
@@ -57,7 +84,8 @@ void GlobalLinkedPool::deallocate(void* t_ptr) {
     m_poolLock.lock();
     if (pool->occupiedSlots == 1) {
         pool_remove(&m_freePools, pool);
-        free(pool);
+        unlinkPool(pool);
+        freePages(pool);
         m_freePool = pool_first(&m_freePools);
     } else {
         auto newNode = new (t_ptr) Node();
@@ -65,6 +93,10 @@ void GlobalLinkedPool::deallocate(void* t_ptr) {
         Node& head = pool->head;
         newNode->next = head.next;
         head.next = newNode;
+        if (m_trackOccupancy) {
+            OccupancyMap::reset(getOccupancy(pool),
+                                getSlotIndex(pool, t_ptr));
+        }
         m_freePool = pool;
         if (--(pool->occupiedSlots) == m_poolSize - 1) {
             pool_insert(&m_freePools, pool);
@@ -73,12 +105,66 @@ void GlobalLinkedPool::deallocate(void* t_ptr) {
     m_poolLock.unlock();
 }
 
+void GlobalLinkedPool::releaseAll() {
+    m_poolLock.lock();
+    releasePools(nullptr);
+    m_poolLock.unlock();
+}
+
+void GlobalLinkedPool::destroyAll(void (*t_destroy)(void*)) {
+    requireOccupancy("destroyAll");
+    m_poolLock.lock();
+    releasePools(t_destroy);
+    m_poolLock.unlock();
+}
+
+void GlobalLinkedPool::releasePools(void (*t_destroy)(void*)) {
+    while (m_pools) {
+        PoolHeaderG* header = m_pools;
+        m_pools = header->nextPool;
+        if (t_destroy) {
+            char* first = getFirstSlot(header);
+            m_occupancy.forEach(getOccupancy(header), [&](size_t t_slot) {
+                t_destroy(first + t_slot * m_slotSize);
+            });
+        }
+        if (header->occupiedSlots < m_poolSize) {
+            pool_remove(&m_freePools, header);
+        }
+        freePages(header);
+    }
+    m_freePool = nullptr;
+}
+
+void GlobalLinkedPool::requireOccupancy(const char* t_caller) const {
+    if (!m_trackOccupancy) {
+        throw std::logic_error(std::string("GlobalLinkedPool::") + t_caller +
+                               " needs a pool which tracks its slots");
+    }
+}
+
+void GlobalLinkedPool::unlinkPool(PoolHeaderG* t_header) {
+    if (t_header->prevPool) {
+        t_header->prevPool->nextPool = t_header->nextPool;
+    } else {
+        m_pools = t_header->nextPool;
+    }
+    if (t_header->nextPool) {
+        t_header->nextPool->prevPool = t_header->prevPool;
+    }
+}
+
 void GlobalLinkedPool::constructPoolHeader(char* t_ptr) {
-    // first slot after the header that is also aligned
+    // first slot after the header (and the bitmap) that is also aligned
     auto headNext = reinterpret_cast<Node*>(sizeof(PoolHeaderG) +
                                             t_ptr + m_headerPadding);
     // create the header at the start of the pool
-    new (t_ptr) PoolHeaderG(m_sizeOfObjects, headNext);
+    auto header = new (t_ptr) PoolHeaderG(m_sizeOfObjects, headNext, this);
+    header->nextPool = m_pools;
+    if (m_pools) {
+        m_pools->prevPool = header;
+    }
+    m_pools = header;
     // skip the header
     t_ptr = reinterpret_cast<char*>(headNext);
     // for each slot in the pool, create a node that is linked to the next slot
@@ -97,6 +183,10 @@ void* GlobalLinkedPool::nextFree(Pool pool) {
     void* toReturn = head.next;
     if (toReturn) {
         head.next = head.next->next;
+        if (m_trackOccupancy) {
+            OccupancyMap::set(getOccupancy(header),
+                              getSlotIndex(header, toReturn));
+        }
         if (++(header->occupiedSlots) == m_poolSize) {
             pool_remove(&m_freePools, pool);
             m_freePool = pool_first(&m_freePools);
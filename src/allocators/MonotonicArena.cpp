@@ -0,0 +1,73 @@
+#include "rpools/allocators/MonotonicArena.hpp"
+
+using namespace rpools;
+
+MonotonicArena::MonotonicArena(size_t t_chunkPages)
+    : m_chunkSize((t_chunkPages ? t_chunkPages : 1) * getPageSize()) {}
+
+MonotonicArena::~MonotonicArena() {
+    release();
+}
+
+void MonotonicArena::reset() {
+    m_chunk = m_chunks;
+    m_current = m_chunk ? getStart(m_chunk) : nullptr;
+    m_end = m_chunk ? getEnd(m_chunk) : nullptr;
+}
+
+void MonotonicArena::rewind(const Marker& t_marker) {
+    if (!t_marker.chunk) {
+        reset();
+        return;
+    }
+    m_chunk = t_marker.chunk;
+    m_current = t_marker.current;
+    m_end = getEnd(m_chunk);
+}
+
+void MonotonicArena::release() {
+    while (m_chunks) {
+        Chunk* next = m_chunks->next;
+        freePages(m_chunks);
+        m_chunks = next;
+    }
+    m_numOfChunks = 0;
+    reset();
+}
+
+void* MonotonicArena::allocateSlow(size_t t_size, size_t t_alignment) {
+    Chunk* next = m_chunk ? m_chunk->next : m_chunks;
+    // the chunks after the current one are free since the last reset
+    if (next) {
+        char* start = getStart(next);
+        char* ptr = start + mod(-reinterpret_cast<size_t>(start), t_alignment);
+        if (ptr + t_size > getEnd(next)) {
+            next = nullptr;
+        }
+    }
+    if (!next) {
+        // the chunk is inserted before the chunks which are too small, so
+        // they can still be used by the next allocations
+        size_t pageSize = getPageSize();
+        size_t size = sizeof(Chunk) + t_size + t_alignment;
+        size = size < m_chunkSize ? m_chunkSize :
+            (size + pageSize - 1) / pageSize * pageSize;
+        next = static_cast<Chunk*>(allocatePages(size / pageSize));
+        if (!next) {
+            return nullptr;
+        }
+        next->size = size;
+        if (m_chunk) {
+            next->next = m_chunk->next;
+            m_chunk->next = next;
+        } else {
+            next->next = m_chunks;
+            m_chunks = next;
+        }
+        ++m_numOfChunks;
+    }
+    m_chunk = next;
+    m_current = getStart(next);
+    m_end = getEnd(next);
+    return allocate(t_size, t_alignment);
+}
@@ -37,7 +37,7 @@ void* NSGlobalLinkedPool::allocate() {
         } else {
             // create a new pool because there are no free pool slots left
             size_t pageSize = getPageSize();
-            Pool pool = aligned_alloc(pageSize, pageSize);
+            Pool pool = allocatePages(1);
             std::memset(pool, 0, pageSize);
             constructPoolHeader(reinterpret_cast<char*>(pool));
             pool_insert(&m_freePools, pool);
@@ -54,7 +54,7 @@ void NSGlobalLinkedPool::deallocate(void* t_ptr) {
     );
     if (pool->occupiedSlots == 1) {
         pool_remove(&m_freePools, pool);
-        free(pool);
+        freePages(pool);
         m_freePool = pool_first(&m_freePools);
     } else {
         auto newNode = new (t_ptr) Node();
@@ -74,7 +74,7 @@ void NSGlobalLinkedPool::constructPoolHeader(char* t_ptr) {
     auto headNext = reinterpret_cast<Node*>(sizeof(PoolHeaderG) +
                                              t_ptr + m_headerPadding);
     // create the header at the start of the pool
-    new (t_ptr) PoolHeaderG(m_sizeOfObjects, headNext);
+    new (t_ptr) PoolHeaderG(m_sizeOfObjects, headNext, this);
     // skip the header
     t_ptr = reinterpret_cast<char*>(headNext);
     // for each slot in the pool, create a node that is linked to the next slot
@@ -0,0 +1,223 @@
+#include <cstring>
+
+#include "rpools/allocators/TLSF.hpp"
+
+using namespace rpools;
+
+/**
+ *  @return the index of the most significant bit of `t_value` (not 0).
+ */
+static size_t fls(size_t t_value) {
+    return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(t_value);
+}
+
+TLSF::TLSF(size_t t_spanSize) {
+    size_t pageSize = getPageSize();
+    m_spanSize = (t_spanSize + pageSize - 1) / pageSize * pageSize;
+    // the span header, the header of the block and the end of span sentinel
+    m_maxAllocation = m_spanSize - sizeof(Span) - 2 * BLOCK_OVERHEAD;
+    std::memset(m_slBitmap, 0, sizeof(m_slBitmap));
+    std::memset(m_blocks, 0, sizeof(m_blocks));
+}
+
+TLSF::~TLSF() {
+    while (m_spans) {
+        Span* next = m_spans->next;
+        freePages(m_spans);
+        m_spans = next;
+    }
+}
+
+void* TLSF::allocate(size_t t_size) {
+    size_t size = (t_size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    size = size < MIN_BLOCK_SIZE ? MIN_BLOCK_SIZE : size;
+    if (size > m_maxAllocation) {
+        return nullptr;
+    }
+    size_t fl = 0;
+    size_t sl = 0;
+    mappingSearch(size, fl, sl);
+    Block* block = findSuitable(fl, sl);
+    if (!block) {
+        // the lists are rounded up, but the first block of the list of
+        // t_size might still be large enough
+        mapping(size, fl, sl);
+        block = m_blocks[fl][sl];
+        if (!block || getSize(block) < size) {
+            // the block of a new span is always large enough
+            block = addSpan();
+            if (!block) {
+                return nullptr;
+            }
+        }
+    }
+    removeFree(block);
+    split(block, size);
+    block->size &= ~FREE_BIT;
+    getNext(block)->size &= ~PREV_FREE_BIT;
+    return reinterpret_cast<char*>(block) + BLOCK_OVERHEAD;
+}
+
+void TLSF::deallocate(void* t_ptr) {
+    if (!t_ptr) {
+        return;
+    }
+    auto block = reinterpret_cast<Block*>(static_cast<char*>(t_ptr) -
+                                          BLOCK_OVERHEAD);
+    block->size |= FREE_BIT;
+    // merge with the previous block
+    if (block->size & PREV_FREE_BIT) {
+        Block* prev = block->prevPhys;
+        removeFree(prev);
+        prev->size += BLOCK_OVERHEAD + getSize(block);
+        block = prev;
+    }
+    // merge with the next block
+    Block* next = getNext(block);
+    if (next->size & FREE_BIT) {
+        removeFree(next);
+        block->size += BLOCK_OVERHEAD + getSize(next);
+        next = getNext(block);
+    }
+    next->prevPhys = block;
+    next->size |= PREV_FREE_BIT;
+    // the block covers its whole span
+    if (!block->prevPhys && getSize(next) == 0 && m_numOfSpans > 1) {
+        releaseSpan(block);
+    } else {
+        insertFree(block);
+    }
+}
+
+size_t TLSF::getBlockSize(const void* t_ptr) {
+    return getSize(reinterpret_cast<const Block*>(
+        static_cast<const char*>(t_ptr) - BLOCK_OVERHEAD));
+}
+
+void TLSF::mapping(size_t t_size, size_t& t_fl, size_t& t_sl) {
+    if (t_size < SMALL_BLOCK_SIZE) {
+        t_fl = 0;
+        t_sl = t_size / (SMALL_BLOCK_SIZE / SL_COUNT);
+    } else {
+        size_t bit = fls(t_size);
+        t_sl = (t_size >> (bit - SL_LOG2)) ^ SL_COUNT;
+        t_fl = bit - FL_SHIFT + 1;
+    }
+}
+
+void TLSF::mappingSearch(size_t t_size, size_t& t_fl, size_t& t_sl) {
+    // round up to the next list, so that any of its blocks is large enough
+    if (t_size >= SMALL_BLOCK_SIZE) {
+        t_size += (size_t(1) << (fls(t_size) - SL_LOG2)) - 1;
+    }
+    mapping(t_size, t_fl, t_sl);
+}
+
+TLSF::Block* TLSF::findSuitable(size_t& t_fl, size_t& t_sl) {
+    if (t_fl >= FL_COUNT) {
+        return nullptr;
+    }
+    uint32_t slMap = m_slBitmap[t_fl] & (~0u << t_sl);
+    if (!slMap) {
+        // look for a larger first level
+        uint64_t flMap = t_fl + 1 < 64 ?
+            m_flBitmap & (~0ull << (t_fl + 1)) : 0;
+        if (!flMap) {
+            return nullptr;
+        }
+        t_fl = __builtin_ctzll(flMap);
+        slMap = m_slBitmap[t_fl];
+    }
+    t_sl = __builtin_ctz(slMap);
+    return m_blocks[t_fl][t_sl];
+}
+
+void TLSF::insertFree(Block* t_block) {
+    size_t fl = 0;
+    size_t sl = 0;
+    mapping(getSize(t_block), fl, sl);
+    Block* head = m_blocks[fl][sl];
+    t_block->nextFree = head;
+    t_block->prevFree = nullptr;
+    if (head) {
+        head->prevFree = t_block;
+    }
+    m_blocks[fl][sl] = t_block;
+    m_flBitmap |= 1ull << fl;
+    m_slBitmap[fl] |= 1u << sl;
+}
+
+void TLSF::removeFree(Block* t_block) {
+    size_t fl = 0;
+    size_t sl = 0;
+    mapping(getSize(t_block), fl, sl);
+    if (t_block->nextFree) {
+        t_block->nextFree->prevFree = t_block->prevFree;
+    }
+    if (t_block->prevFree) {
+        t_block->prevFree->nextFree = t_block->nextFree;
+    } else {
+        m_blocks[fl][sl] = t_block->nextFree;
+        if (!m_blocks[fl][sl]) {
+            m_slBitmap[fl] &= ~(1u << sl);
+            if (!m_slBitmap[fl]) {
+                m_flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+}
+
+void TLSF::split(Block* t_block, size_t t_size) {
+    size_t size = getSize(t_block);
+    if (size < t_size + BLOCK_OVERHEAD + MIN_BLOCK_SIZE) {
+        return;
+    }
+    auto rest = reinterpret_cast<Block*>(reinterpret_cast<char*>(t_block) +
+                                         BLOCK_OVERHEAD + t_size);
+    // t_block is about to be used
+    rest->prevPhys = t_block;
+    rest->size = (size - t_size - BLOCK_OVERHEAD) | FREE_BIT;
+    t_block->size = t_size | (t_block->size & (ALIGNMENT - 1));
+    Block* next = getNext(rest);
+    next->prevPhys = rest;
+    next->size |= PREV_FREE_BIT;
+    insertFree(rest);
+}
+
+TLSF::Block* TLSF::addSpan() {
+    void* pages = allocatePages(m_spanSize / getPageSize());
+    if (!pages) {
+        return nullptr;
+    }
+    auto span = static_cast<Span*>(pages);
+    span->prev = nullptr;
+    span->next = m_spans;
+    if (m_spans) {
+        m_spans->prev = span;
+    }
+    m_spans = span;
+    ++m_numOfSpans;
+    auto block = reinterpret_cast<Block*>(span + 1);
+    block->prevPhys = nullptr;
+    block->size = m_maxAllocation | FREE_BIT;
+    // the sentinel at the end of the span, which is never free
+    Block* sentinel = getNext(block);
+    sentinel->prevPhys = block;
+    sentinel->size = PREV_FREE_BIT;
+    insertFree(block);
+    return block;
+}
+
+void TLSF::releaseSpan(Block* t_block) {
+    auto span = reinterpret_cast<Span*>(t_block) - 1;
+    if (span->prev) {
+        span->prev->next = span->next;
+    } else {
+        m_spans = span->next;
+    }
+    if (span->next) {
+        span->next->prev = span->prev;
+    }
+    --m_numOfSpans;
+    freePages(span);
+}
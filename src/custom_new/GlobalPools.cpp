@@ -1,27 +1,172 @@
 #include "GlobalPools.hpp"
 
 #include <cstddef>
-#include <cmath>
+#include <new>
+#include <type_traits>
+#include <sched.h>
 
-using std::vector;
+using rpools::BitPool;
+using rpools::BitPoolHeader;
 using rpools::GlobalLinkedPool;
+using rpools::PoolHeaderG;
 
-const size_t __void = sizeof(void*);
-const size_t __logOfVoid = std::log2(__void);
+static_assert(std::is_trivially_default_constructible<GlobalPools>::value,
+              "GlobalPools must be usable before constructors run");
+static_assert(std::is_trivially_destructible<GlobalPools>::value,
+              "GlobalPools must outlive atexit handlers");
+static_assert(offsetof(BitPoolHeader, sizeOfSlot) ==
+              offsetof(PoolHeaderG, sizeOfSlot),
+              "isTiny reads the slot size of both kinds of pages");
 
-GlobalPools::GlobalPools(size_t t_numOfPools)
-    : m_pools() {
-    m_pools.reserve(t_numOfPools);
-    for (size_t i = __void; i <= t_numOfPools * __void; i += __void) {
-        size_t alignment = (i & (alignof(max_align_t) - 1)) == 0 ?
-            alignof(max_align_t) : __void;
-        m_pools.emplace_back(i, alignment);
+void* GlobalPools::allocateSlow(size_t t_index) {
+    GlobalLinkedPool* pool = createPool(t_index);
+    // the calling thread is creating a pool and allocates again
+    return pool ? pool->allocate() : allocateBootstrap(rpools::getClassSize(
+        t_index % rpools::NUM_OF_SIZE_CLASSES));
+}
+
+void GlobalPools::reserve(size_t t_class, size_t t_sites) {
+    size_t sites = m_sites[t_class].fetch_add(t_sites,
+                                              std::memory_order_relaxed);
+    sites += t_sites;
+    // the manifest describes the long-lived pools, short-lived objects are
+    // expected to reuse their slots
+    size_t index = getIndex(t_class, rpools::LONG_LIVED);
+    GlobalLinkedPool* pool = m_pools[index].load(std::memory_order_acquire);
+    if (!pool) {
+        pool = createPool(index);
+    }
+    if (pool) {
+        size_t pages = 1 + sites / SITES_PER_PAGE;
+        pool->reserve(pages < MAX_RESERVED_PAGES ? pages : MAX_RESERVED_PAGES);
+    }
+}
+
+GlobalLinkedPool* GlobalPools::createPool(size_t t_index) {
+    if (!lockInit()) {
+        return nullptr;
+    }
+    // another thread might have created the pool while we were waiting
+    GlobalLinkedPool* pool = m_pools[t_index].load(std::memory_order_relaxed);
+    if (!pool) {
+        size_t sizeClass = t_index % rpools::NUM_OF_SIZE_CLASSES;
+        pool = new (m_storage[t_index]) GlobalLinkedPool(
+            rpools::getClassSize(sizeClass),
+            rpools::getClassAlignment(sizeClass));
+        m_pools[t_index].store(pool, std::memory_order_release);
+    }
+    unlockInit();
+    return pool;
+}
+
+bool GlobalPools::lockInit() {
+    // it would deadlock if the calling thread waited for the pool that it
+    // is creating
+    if (pthread_equal(m_initOwner.load(std::memory_order_relaxed),
+                      pthread_self())) {
+        return false;
+    }
+    while (m_initLock.test_and_set(std::memory_order_acquire)) {
+        sched_yield();
+    }
+    m_initOwner.store(pthread_self(), std::memory_order_relaxed);
+    return true;
+}
+
+void GlobalPools::unlockInit() {
+    m_initOwner.store(pthread_t(), std::memory_order_relaxed);
+    m_initLock.clear(std::memory_order_release);
+}
+
+void* GlobalPools::allocateTiny(size_t t_class) {
+    switch (t_class) {
+    case 0:
+        return allocateTiny(m_tiny1);
+    case 1:
+        return allocateTiny(m_tiny2);
+    default:
+        return allocateTiny(m_tiny4);
+    }
+}
+
+void GlobalPools::deallocateTiny(void* t_ptr) {
+    // the pool of a page is known from the size of its slots
+    switch (getTinyHeader(t_ptr).sizeOfSlot) {
+    case 1:
+        m_tiny1.pool.load(std::memory_order_relaxed)->deallocate(t_ptr);
+        break;
+    case 2:
+        m_tiny2.pool.load(std::memory_order_relaxed)->deallocate(t_ptr);
+        break;
+    default:
+        m_tiny4.pool.load(std::memory_order_relaxed)->deallocate(t_ptr);
+        break;
+    }
+}
+
+template<typename T>
+void* GlobalPools::allocateTiny(TinyPool<T>& t_tiny) {
+    BitPool<T>* pool = t_tiny.pool.load(std::memory_order_acquire);
+    if (!pool) {
+        if (!lockInit()) {
+            // the calling thread is creating a pool and allocates again
+            return allocateBootstrap(sizeof(T));
+        }
+        pool = t_tiny.pool.load(std::memory_order_relaxed);
+        if (!pool) {
+            pool = new (t_tiny.storage) BitPool<T>();
+            t_tiny.pool.store(pool, std::memory_order_release);
+        }
+        unlockInit();
+    }
+    return pool->allocate();
+}
+
+void* GlobalPools::allocateMid(size_t t_size, size_t& t_shard) {
+    // threads that run on different CPUs use different shards
+    int cpu = sched_getcpu();
+    t_shard = cpu < 0 ? 0 : static_cast<size_t>(cpu) % MID_SHARDS;
+    MidShard& shard = m_mid[t_shard];
+    rpools::TLSF* tlsf = shard.tlsf.load(std::memory_order_acquire);
+    if (!tlsf) {
+        tlsf = createMidShard(shard);
+    }
+    shard.lock->lock();
+    void* ptr = tlsf->allocate(t_size);
+    shard.lock->unlock();
+    return ptr;
+}
+
+void GlobalPools::deallocateMid(void* t_ptr, size_t t_shard) {
+    MidShard& shard = m_mid[t_shard];
+    shard.lock->lock();
+    shard.tlsf.load(std::memory_order_relaxed)->deallocate(t_ptr);
+    shard.lock->unlock();
+}
+
+rpools::TLSF* GlobalPools::createMidShard(MidShard& t_shard) {
+    while (t_shard.initLock.test_and_set(std::memory_order_acquire)) {
+        sched_yield();
+    }
+    rpools::TLSF* tlsf = t_shard.tlsf.load(std::memory_order_relaxed);
+    if (!tlsf) {
+        // TLSF requests its spans with allocatePages, so creating it or
+        // using it never allocates through custom_new
+        t_shard.lock = new (t_shard.lockStorage) rpools::LMLock();
+        tlsf = new (t_shard.storage) rpools::TLSF(MID_SPAN_SIZE);
+        t_shard.tlsf.store(tlsf, std::memory_order_release);
     }
+    t_shard.initLock.clear(std::memory_order_release);
+    return tlsf;
 }
 
-GlobalLinkedPool& GlobalPools::getPool(size_t t_size) {
-    if (t_size == 0) {
-        return m_pools[0];
+void* GlobalPools::allocateBootstrap(size_t t_size) {
+    // keep every allocation aligned at alignof(max_align_t)
+    size_t size = (t_size + alignof(max_align_t) - 1) &
+        ~(alignof(max_align_t) - 1);
+    size_t offset = m_bootstrapUsed.fetch_add(size, std::memory_order_relaxed);
+    if (offset + size > BOOTSTRAP_SIZE) {
+        return nullptr;
     }
-    return m_pools[(t_size >> __logOfVoid) - 1];
+    return m_bootstrap + offset;
 }
@@ -1,38 +1,239 @@
 #ifndef __GLOBAL_POOLS_H__
 #define __GLOBAL_POOLS_H__
 
-#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
 
-#include "rpools/tools/mallocator.hpp"
+#include "rpools/allocators/BitPool.hpp"
 #include "rpools/allocators/GlobalLinkedPool.hpp"
+#include "rpools/allocators/TLSF.hpp"
+#include "rpools/custom_new/size_classes.hpp"
+#include "rpools/tools/LMLock.hpp"
 
 /**
  *  Represents a class which holds `GlobalLinkedPool`s that can
  *  hold objects that are multiples of 8.
  *  @par
- *  Example: GlobalPools(8) will create 8 `GlobalLinkedPool`s.
  *  The first pool can hold objects of sizes up to 8 and will align them
  *  at 8 byte boundaries. The 2nd pool will hold objects of size 16, but will
  *  align them at 16 byte boundaries, and so on.
+ *  @par
+ *  Every size class has a pool for each `rpools::Lifetime`, so that objects
+ *  which are expected to die soon do not share pages with long-lived ones.
+ *  @par
+ *  Allocations of at most `rpools::TINY_THRESHOLD` bytes are made in the
+ *  tiny classes, which are `BitPool`s of 1, 2 and 4 byte slots. A slot of a
+ *  `GlobalLinkedPool` holds a free list `Node` and cannot be smaller than 8
+ *  bytes, whereas the free slots of a `BitPool` are kept in a bitmap.
+ *  @par
+ *  A pool is only created when the first object of its size is allocated.
+ *  `GlobalPools` has no constructors and no destructor on purpose: an
+ *  instance with static storage duration is zero-initialised before any
+ *  code runs (no guard is needed to access it) and it is never destroyed,
+ *  so objects can still be deallocated by `atexit` handlers.
+ *  @par
+ *  Allocations that are too large for the pools but at most
+ *  `MID_THRESHOLD` bytes are made in the mid-size tier, which consists of
+ *  `MID_SHARDS` `TLSF` allocators with a lock each. A thread allocates in
+ *  the shard of the CPU it runs on, so that threads on different CPUs
+ *  rarely wait for each other, and memory is returned to the shard which
+ *  allocated it. A shard is created by its first allocation.
+ *  @par
+ *  Allocations that are made by a thread while it creates a pool (e.g. from
+ *  the dynamic loader) are served by a small static bootstrap arena.
+ *  Memory from the bootstrap arena is never reused.
  */
 class GlobalPools {
 public:
+    /** The number of pools, one for each size class and lifetime. */
+    static const size_t NUM_OF_POOLS =
+        rpools::NUM_OF_SIZE_CLASSES * rpools::NUM_OF_LIFETIMES;
+    /** The number of bytes of the bootstrap arena. */
+    static const size_t BOOTSTRAP_SIZE = 16 * 1024;
+    /** The largest allocation of the mid-size tier. */
+    static const size_t MID_THRESHOLD = 4096;
+    /** The size of the spans of the mid-size tier. */
+    static const size_t MID_SPAN_SIZE = 256 * 1024;
+    /** The number of shards of the mid-size tier. */
+    static const size_t MID_SHARDS = 8;
+    /** The number of allocation sites for which a page is reserved. */
+    static const size_t SITES_PER_PAGE = 16;
+    /** The maximum number of pages that are reserved for a size class. */
+    static const size_t MAX_RESERVED_PAGES = 4;
+
+    /**
+     *  Allocates an object in the pool of the given size class.
+     *  @param t_class the index of a size class (@see rpools::getSizeClass)
+     *  @param t_lifetime the expected lifetime of the object
+     *  @return a pointer to the allocated object, or nullptr if the
+     *          allocation failed.
+     */
+    void* allocate(size_t t_class,
+                   rpools::Lifetime t_lifetime=rpools::LONG_LIVED) {
+        size_t index = getIndex(t_class, t_lifetime);
+        rpools::GlobalLinkedPool* pool =
+            m_pools[index].load(std::memory_order_acquire);
+        return pool ? pool->allocate() : allocateSlow(index);
+    }
+
+    /**
+     *  Creates the pool of `t_class` (if needed) and records that `t_sites`
+     *  more allocation sites use it. The pool reserves a page for every
+     *  `SITES_PER_PAGE` sites, up to `MAX_RESERVED_PAGES` pages.
+     *  @param t_class the index of a size class (@see rpools::getSizeClass)
+     *  @param t_sites the number of allocation sites of a module which
+     *                 allocate in the size class
+     */
+    void reserve(size_t t_class, size_t t_sites);
+
+    /**
+     *  Allocates an object in the pool of the given tiny class.
+     *  @param t_class the index of a tiny class (@see rpools::getTinyClass)
+     *  @return a pointer to the allocated object, or nullptr if the
+     *          allocation failed.
+     */
+    void* allocateTiny(size_t t_class);
+
+    /**
+     *  Deallocates memory which was allocated by `allocateTiny`.
+     */
+    void deallocateTiny(void* t_ptr);
+
+    /**
+     *  @param t_ptr a pointer to a slot of a `GlobalLinkedPool` or of a
+     *               tiny class
+     *  @return whether `t_ptr` was allocated by `allocateTiny`.
+     */
+    static bool isTiny(void* t_ptr) {
+        return getTinyHeader(t_ptr).sizeOfSlot <= rpools::TINY_THRESHOLD;
+    }
+
     /**
-     *  Allocates `t_numOfPools` pools.
-     *  @param t_numOfPools the number of `GlobalLinkedPool`s to allocate
+     *  Allocates `t_size` bytes in the mid-size tier.
+     *  @param t_size at most `MID_THRESHOLD` bytes
+     *  @param t_shard set to the shard which made the allocation
+     *  @return a pointer aligned at `rpools::TLSF::ALIGNMENT`, or nullptr if
+     *          the allocation failed.
      */
-    GlobalPools(size_t t_numOfPools);
+    void* allocateMid(size_t t_size, size_t& t_shard);
 
     /**
-     *  Gets the `GlobalLinkedPool` that can hold objects of sizes up to
-     *  `t_size * 8`.
+     *  Deallocates memory which was allocated by `allocateMid`.
+     *  @param t_shard the shard which made the allocation
      */
-    rpools::GlobalLinkedPool& getPool(size_t t_size);
-    virtual ~GlobalPools() = default;
+    void deallocateMid(void* t_ptr, size_t t_shard);
+
+    /**
+     *  @return whether `t_ptr` was allocated in the bootstrap arena.
+     */
+    bool isBootstrap(const void* t_ptr) const {
+        auto ptr = static_cast<const char*>(t_ptr);
+        return ptr >= m_bootstrap && ptr < m_bootstrap + BOOTSTRAP_SIZE;
+    }
+
 private:
-    std::vector<rpools::GlobalLinkedPool,
-                mallocator<rpools::GlobalLinkedPool>
-    > m_pools;
+    /**
+     *  A shard of the mid-size tier, which is created by its first
+     *  allocation. Every shard has cache lines of its own.
+     */
+    struct alignas(64) MidShard {
+        std::atomic<rpools::TLSF*> tlsf;
+        /** Taken while the shard is used. */
+        rpools::LMLock* lock;
+        /** Taken while the shard is created. */
+        std::atomic_flag initLock;
+        alignas(rpools::TLSF) unsigned char storage[sizeof(rpools::TLSF)];
+        alignas(rpools::LMLock)
+        unsigned char lockStorage[sizeof(rpools::LMLock)];
+    };
+
+    /**
+     *  The pool of a tiny class, which is created by its first allocation.
+     */
+    template<typename T>
+    struct TinyPool {
+        std::atomic<rpools::BitPool<T>*> pool;
+        alignas(rpools::BitPool<T>)
+        unsigned char storage[sizeof(rpools::BitPool<T>)];
+    };
+
+    std::atomic<rpools::GlobalLinkedPool*> m_pools[NUM_OF_POOLS];
+    /** Memory in which the pools are created. */
+    alignas(rpools::GlobalLinkedPool)
+    unsigned char m_storage[NUM_OF_POOLS][sizeof(rpools::GlobalLinkedPool)];
+    /** Taken while a pool is created. */
+    std::atomic_flag m_initLock;
+    /** The thread which is creating a pool, if any. */
+    std::atomic<pthread_t> m_initOwner;
+    alignas(alignof(max_align_t)) char m_bootstrap[BOOTSTRAP_SIZE];
+    std::atomic<size_t> m_bootstrapUsed;
+    MidShard m_mid[MID_SHARDS];
+    /** The allocation sites of every size class (@see reserve). */
+    std::atomic<size_t> m_sites[rpools::NUM_OF_SIZE_CLASSES];
+    TinyPool<uint8_t> m_tiny1;
+    TinyPool<uint16_t> m_tiny2;
+    TinyPool<uint32_t> m_tiny4;
+
+    /**
+     *  @return the index of the pool of `t_class` and `t_lifetime`.
+     */
+    static size_t getIndex(size_t t_class, rpools::Lifetime t_lifetime) {
+        return t_lifetime * rpools::NUM_OF_SIZE_CLASSES + t_class;
+    }
+
+    /**
+     *  @return the header of the page of `t_ptr`, if it is a page of a tiny
+     *          class.
+     */
+    static const rpools::BitPoolHeader& getTinyHeader(void* t_ptr) {
+        size_t poolAddress = reinterpret_cast<size_t>(t_ptr) &
+            rpools::getPoolMask();
+        return *reinterpret_cast<rpools::BitPoolHeader*>(poolAddress);
+    }
+
+    /**
+     *  Takes `m_initLock`, which is held while a pool is created.
+     *  @return false if the calling thread already holds it.
+     */
+    bool lockInit();
+
+    void unlockInit();
+
+    /**
+     *  Creates the pool at `t_index` if it does not exist.
+     *  @return the pool, or nullptr if the calling thread is already
+     *          creating a pool.
+     */
+    rpools::GlobalLinkedPool* createPool(size_t t_index);
+
+    /**
+     *  Creates the pool at `t_index` (if needed) and allocates an object in
+     *  it, or in the bootstrap arena if the calling thread is already
+     *  creating a pool.
+     */
+    void* allocateSlow(size_t t_index);
+
+    /**
+     *  Creates the pool of `t_tiny` (if needed) and allocates an object in
+     *  it, or in the bootstrap arena if the calling thread is already
+     *  creating a pool.
+     */
+    template<typename T>
+    void* allocateTiny(TinyPool<T>& t_tiny);
+
+    /**
+     *  Creates the `TLSF` allocator and the lock of `t_shard`, if another
+     *  thread has not created them yet.
+     */
+    static rpools::TLSF* createMidShard(MidShard& t_shard);
+
+    /**
+     *  Allocates `t_size` bytes from the bootstrap arena.
+     *  @return nullptr if the arena is exhausted.
+     */
+    void* allocateBootstrap(size_t t_size);
 };
 
 #endif // __GLOBAL_POOLS_H__
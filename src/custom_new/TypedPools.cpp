@@ -0,0 +1,47 @@
+#include "TypedPools.hpp"
+
+#include <new>
+#include <type_traits>
+
+using rpools::GlobalLinkedPool;
+
+static_assert(std::is_trivially_default_constructible<TypedPools>::value,
+              "TypedPools must be usable before constructors run");
+static_assert(std::is_trivially_destructible<TypedPools>::value,
+              "TypedPools must outlive atexit handlers");
+
+TypedPools::Entry* TypedPools::find(size_t t_typeId, size_t t_class) {
+    // open addressing, entries are never removed
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        Entry& entry = m_entries[(t_typeId + i) % CAPACITY];
+        size_t id = entry.typeId.load(std::memory_order_relaxed);
+        if (id == t_typeId) {
+            return &entry;
+        }
+        if (id == 0) {
+            if (entry.typeId.compare_exchange_strong(
+                    id, t_typeId, std::memory_order_relaxed)) {
+                entry.sizeClass.store(t_class + 1, std::memory_order_relaxed);
+                return &entry;
+            } else if (id == t_typeId) {
+                // another thread claimed the entry for the same type
+                return &entry;
+            }
+        }
+    }
+    return nullptr;
+}
+
+GlobalLinkedPool* TypedPools::countAllocation(Entry& t_entry) {
+    size_t allocations =
+        t_entry.allocations.fetch_add(1, std::memory_order_relaxed) + 1;
+    // only the thread which makes the type hot creates the pool
+    if (allocations != HOT_THRESHOLD) {
+        return t_entry.pool.load(std::memory_order_acquire);
+    }
+    size_t sizeClass = t_entry.sizeClass.load(std::memory_order_relaxed) - 1;
+    auto pool = new (m_storage[&t_entry - m_entries]) GlobalLinkedPool(
+        rpools::getClassSize(sizeClass), rpools::getClassAlignment(sizeClass));
+    t_entry.pool.store(pool, std::memory_order_release);
+    return pool;
+}
@@ -0,0 +1,77 @@
+#ifndef __TYPED_POOLS_H__
+#define __TYPED_POOLS_H__
+
+#include <atomic>
+#include <cstddef>
+
+#include "rpools/allocators/GlobalLinkedPool.hpp"
+#include "rpools/custom_new/size_classes.hpp"
+
+/**
+ *  Represents a class which gives the types that are allocated often
+ *  (hot types) a `GlobalLinkedPool` of their own, so that objects of the
+ *  same type share pages.
+ *  @par
+ *  Types are identified by the IDs which the `CustomNewDelete` pass passes
+ *  to `custom_new_typed`. A type gets its own pool after `HOT_THRESHOLD`
+ *  allocations, and at most `CAPACITY` types get one.
+ *  @par
+ *  Like `GlobalPools`, `TypedPools` has no constructors and no destructor,
+ *  so an instance with static storage duration can be used at any time.
+ */
+class TypedPools {
+public:
+    /** The maximum number of types that get their own pool. */
+    static const size_t CAPACITY = 64;
+    /** The number of allocations after which a type gets its own pool. */
+    static const size_t HOT_THRESHOLD = 64;
+
+    /**
+     *  @param t_typeId the ID of the allocated type (cannot be 0)
+     *  @param t_class the size class of the allocated type
+     *  @return the pool of the type, or nullptr if the allocation should be
+     *          made in the pool of its size class.
+     */
+    rpools::GlobalLinkedPool* getPool(size_t t_typeId, size_t t_class) {
+        Entry* entry = find(t_typeId, t_class);
+        // the same type can be allocated in different size classes
+        // (e.g. arrays), only the first one gets a pool
+        if (!entry ||
+            entry->sizeClass.load(std::memory_order_relaxed) != t_class + 1) {
+            return nullptr;
+        }
+        rpools::GlobalLinkedPool* pool =
+            entry->pool.load(std::memory_order_acquire);
+        return pool ? pool : countAllocation(*entry);
+    }
+
+private:
+    struct Entry {
+        /** 0 if the entry is empty. */
+        std::atomic<size_t> typeId;
+        /** The size class of the type plus 1, or 0 until it is known. */
+        std::atomic<size_t> sizeClass;
+        std::atomic<size_t> allocations;
+        std::atomic<rpools::GlobalLinkedPool*> pool;
+    };
+
+    Entry m_entries[CAPACITY];
+    /** Memory in which the pools are created. */
+    alignas(rpools::GlobalLinkedPool)
+    unsigned char m_storage[CAPACITY][sizeof(rpools::GlobalLinkedPool)];
+
+    /**
+     *  @return the entry of `t_typeId` (which is created for `t_class` if
+     *          needed), or nullptr if the table is full.
+     */
+    Entry* find(size_t t_typeId, size_t t_class);
+
+    /**
+     *  Records an allocation of the type of `t_entry` and creates its pool
+     *  once the type becomes hot.
+     *  @return the pool of the type, or nullptr if it is not hot yet.
+     */
+    rpools::GlobalLinkedPool* countAllocation(Entry& t_entry);
+};
+
+#endif // __TYPED_POOLS_H__
@@ -1,32 +1,103 @@
 #include "rpools/custom_new/custom_new_delete.hpp"
 
-#include <cmath>
 #include <cstring>
 
 #include "GlobalPools.hpp"
+#include "TypedPools.hpp"
+#include "rpools/custom_new/size_classes.hpp"
 
 namespace {
     using namespace rpools;
 
-    const size_t __threshold = 128; // malloc performs equally well
-                                    // on objects of size > 128
-    const size_t __mod = sizeof(void*) - 1;
-    const size_t __logOfVoid = std::log2(sizeof(void*));
+    const size_t __threshold = CUSTOM_NEW_THRESHOLD;
+    // larger allocations are malloc-d
+    const size_t __midThreshold = GlobalPools::MID_THRESHOLD;
 
     // Used to mark the first 16 bytes of a malloc-d region
     struct MallocHeader {
         char validity[16] = "              \0";
     };
 
-    GlobalPools& getPools() {
-        static GlobalPools pools(__threshold >> __logOfVoid);
-        return pools;
+    // the mid-size tier marks its regions with a different string
+    const char* const __midValidity = "IsThIsMiDsIzE!\0";
+
+    // the mid-size tier keeps the shard of a region in the last byte of its
+    // header, after the end of __midValidity
+    const size_t __midShardByte = sizeof(MallocHeader) - 1;
+
+    static_assert(GlobalPools::MID_SHARDS <= 256,
+                  "the shard of a region is kept in a byte");
+
+    static_assert(sizeof(MallocHeader) % TLSF::ALIGNMENT == 0,
+                  "the mid-size tier must return aligned memory");
+
+    // zero-initialised before any code runs and never destroyed
+    // (see GlobalPools)
+    GlobalPools __pools;
+
+    static_assert(NUM_OF_SIZE_CLASSES * sizeof(void*) == __threshold,
+                  "every size up to the threshold needs a pool");
+
+    // the pools of the hot types (see TypedPools)
+    TypedPools __typedPools;
+
+    inline GlobalPools& getPools() {
+        return __pools;
+    }
+
+    inline TypedPools& getTypedPools() {
+        return __typedPools;
+    }
+
+    /**
+     *  Deallocates a region of the mid-size tier.
+     *  @param t_header the header in front of the region
+     */
+    inline void deallocateMid(MallocHeader* t_header) {
+        getPools().deallocateMid(t_header, static_cast<unsigned char>(
+            t_header->validity[__midShardByte]));
+    }
+
+    /**
+     *  @return the alignment of the memory that `operator new` returns for
+     *          `t_size` bytes.
+     */
+    inline size_t getNewAlignment(size_t t_size) {
+        // no object is aligned at more than its size, so small allocations
+        // do not need the alignment of max_align_t
+        return getNaturalAlignment(t_size);
+    }
+
+    /**
+     *  Deallocates a pointer of a pool of a size class, of a hot type or of
+     *  a tiny class.
+     */
+    inline void deallocatePooled(void* t_ptr) {
+        if (GlobalPools::isTiny(t_ptr)) {
+            getPools().deallocateTiny(t_ptr);
+        } else {
+            // the pool might belong to a size class or to a hot type
+            const PoolHeaderG& ph = GlobalLinkedPool::getPoolHeader(t_ptr);
+            static_cast<GlobalLinkedPool*>(ph.owner)->deallocate(t_ptr);
+        }
     }
 }
 
 void* custom_new_no_throw(size_t t_size, size_t t_alignment) {
-    // use malloc for large sizes
-    if (t_size > __threshold) {
+    if (t_size > __threshold && t_size <= __midThreshold) {
+        // the mid-size tier uses the same kind of header as malloc
+        size_t shard = 0;
+        auto addr = static_cast<char*>(getPools().allocateMid(
+            t_size + sizeof(MallocHeader), shard));
+        if (!addr) {
+            return nullptr;
+        }
+        auto header = new(addr) MallocHeader();
+        std::strcpy(header->validity, __midValidity);
+        header->validity[__midShardByte] = static_cast<char>(shard);
+        return addr + sizeof(MallocHeader);
+    } else if (t_size > __threshold) {
+        // use malloc for large sizes
         // add sizeof(MallocHeader) extra space to denote the fact that the
         // allocation is malloc-d
         auto addr = static_cast<char*>(std::malloc(t_size +
@@ -35,20 +106,10 @@ void* custom_new_no_throw(size_t t_size, size_t t_alignment) {
         std::strcpy(header->validity, "IsThIsMaLlOcD!\0");
         // make sure we do not return the extra memory
         return addr + sizeof(MallocHeader);
+    } else if (isTinyAllocation(t_size, t_alignment)) {
+        return getPools().allocateTiny(getTinyClass(t_size));
     } else {
-        size_t remainder = t_size & __mod; // t_size % sizeof(void*)
-        // round up to the next multiple of sizeof(void*)
-        t_size = remainder == 0 ? t_size : (t_size + __mod) & ~__mod;
-        // adds 8 in the case when a pool of <t_size> cannot accommodate
-        // an allocation request of alignment <t_alignment>
-        // say t_size is 40 and t_alignment is 16
-        // we have defined that pools that are not divisible by
-        // 16, have alignment 8, otherwise 16
-        // 40 % 16 != 0 -> place the request in a pool that holds
-        // objects of size 48 (also note 48 % 16 == 0 -> has an alignment of 16)
-        t_size += (mod(t_size, t_alignment)) == 0 ? 0 : sizeof(void*);
-        void* addr = getPools().getPool(t_size).allocate();
-        return addr;
+        return getPools().allocate(getSizeClass(t_size, t_alignment));
     }
 }
 
@@ -60,7 +121,49 @@ void* custom_new(size_t t_size, size_t t_alignment) {
     return toRet;
 }
 
+void* custom_new_class_no_throw(size_t t_class) {
+    return getPools().allocate(t_class);
+}
+
+void* custom_new_class(size_t t_class) {
+    void* toRet = getPools().allocate(t_class);
+    if (toRet == nullptr) {
+        throw std::bad_alloc();
+    }
+    return toRet;
+}
+
+void* custom_new_lifetime_no_throw(size_t t_class, size_t t_lifetime) {
+    return getPools().allocate(t_class, t_lifetime == SHORT_LIVED ?
+                                        SHORT_LIVED : LONG_LIVED);
+}
+
+void* custom_new_lifetime(size_t t_class, size_t t_lifetime) {
+    void* toRet = custom_new_lifetime_no_throw(t_class, t_lifetime);
+    if (toRet == nullptr) {
+        throw std::bad_alloc();
+    }
+    return toRet;
+}
+
+void* custom_new_typed_no_throw(size_t t_class, size_t t_typeId) {
+    GlobalLinkedPool* pool = getTypedPools().getPool(t_typeId, t_class);
+    return pool ? pool->allocate() : getPools().allocate(t_class);
+}
+
+void* custom_new_typed(size_t t_class, size_t t_typeId) {
+    void* toRet = custom_new_typed_no_throw(t_class, t_typeId);
+    if (toRet == nullptr) {
+        throw std::bad_alloc();
+    }
+    return toRet;
+}
+
 void custom_delete(void* t_ptr) noexcept {
+    // the bootstrap arena is never reused
+    if (getPools().isBootstrap(t_ptr)) {
+        return;
+    }
     // find out if the pointer was allocated with malloc
     // or within a pool
     auto cAddr = reinterpret_cast<char*>(t_ptr);
@@ -71,11 +174,35 @@ void custom_delete(void* t_ptr) noexcept {
     auto header = reinterpret_cast<MallocHeader*>(cAddr);
     if (std::strcmp(header->validity, "IsThIsMaLlOcD!\0") == 0) {
         free(cAddr);
+    } else if (std::strcmp(header->validity, __midValidity) == 0) {
+        deallocateMid(header);
     } else {
-        const PoolHeaderG& ph = GlobalLinkedPool::getPoolHeader(t_ptr);
-        // convert the size to an index of the allocators vector
-        // by dividing it to sizeof(void*)
-        getPools().getPool(ph.sizeOfSlot).deallocate(t_ptr);
+        deallocatePooled(t_ptr);
+    }
+}
+
+void custom_delete_sized(void* t_ptr, size_t t_size,
+                         size_t t_alignment) noexcept {
+    // the size decides where custom_new placed the object, so the malloc
+    // header does not have to be checked
+    if (t_size > __midThreshold) {
+        free(static_cast<char*>(t_ptr) - sizeof(MallocHeader));
+    } else if (t_size > __threshold) {
+        deallocateMid(reinterpret_cast<MallocHeader*>(
+            static_cast<char*>(t_ptr) - sizeof(MallocHeader)));
+    } else if (!getPools().isBootstrap(t_ptr)) {
+        // a tiny allocation might have been made with a different alignment
+        // (e.g. custom_new_class), so the page tells where it is
+        deallocatePooled(t_ptr);
+    }
+}
+
+void custom_new_register_manifest(const size_t* t_sites,
+                                  size_t t_numOfClasses) noexcept {
+    for (size_t i = 0; i < t_numOfClasses && i < NUM_OF_SIZE_CLASSES; ++i) {
+        if (t_sites[i] != 0) {
+            getPools().reserve(i, t_sites[i]);
+        }
     }
 }
 
@@ -90,11 +217,11 @@ void custom_delete(void* t_ptr) noexcept {
 // Note that the C++14/17/20 operators are not included!
 
 void* operator new(std::size_t t_size) {
-    return custom_new(t_size);
+    return custom_new(t_size, getNewAlignment(t_size));
 }
 
 void* operator new(std::size_t t_size, const std::nothrow_t& nothrow_value) noexcept {
-    return custom_new_no_throw(t_size);
+    return custom_new_no_throw(t_size, getNewAlignment(t_size));
 }
 
 void operator delete(void* t_ptr) noexcept {
@@ -110,7 +237,7 @@ void operator delete(void* t_ptr, const std::nothrow_t& nothrow_value) noexcept
 }
 
 void* operator new[](std::size_t t_size) {
-    void* toRet = custom_new(t_size);
+    void* toRet = custom_new(t_size, getNewAlignment(t_size));
     if (toRet == nullptr) {
         throw std::bad_alloc();
     }
@@ -118,7 +245,7 @@ void* operator new[](std::size_t t_size) {
 }
 
 void* operator new[](std::size_t t_size, const std::nothrow_t& nothrow_value) noexcept {
-    return custom_new_no_throw(t_size);
+    return custom_new_no_throw(t_size, getNewAlignment(t_size));
 }
 
 void operator delete[](void* t_ptr) noexcept {
@@ -0,0 +1,90 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+using std::vector;
+
+#include "TestObject.h"
+#include "TestObject2.h"
+#include "rpools/allocators/BitPool.hpp"
+using namespace rpools;
+
+template<typename T>
+void test_fill_pool() {
+    BitPool<T> bp;
+    size_t size = bp.getPoolSize();
+    REQUIRE(size > 0);
+    vector<char*> objs;
+    for (size_t i = 0; i < size; ++i) {
+        objs.push_back(static_cast<char*>(bp.allocate()));
+        REQUIRE((size_t)objs.back() % alignof(T) == 0);
+        // the slots of a page are used from the lowest address
+        if (i > 0) {
+            REQUIRE(objs[i] > objs[i - 1]);
+        }
+        // the slot does not cross the page
+        REQUIRE(((size_t)objs[i] & getPoolMask()) ==
+                ((size_t)(objs[i] + sizeof(T) - 1) & getPoolMask()));
+    }
+    REQUIRE(bp.getNumberOfPools() == 1);
+    bp.allocate();
+    REQUIRE(bp.getNumberOfPools() == 2);
+}
+
+TEST_CASE("A page of a BitPool is filled before a new one is allocated",
+          "[BitPool]") {
+    SECTION("TestObject") {
+        test_fill_pool<TestObject>();
+    }
+    SECTION("TestObject2") {
+        test_fill_pool<TestObject2>();
+    }
+    SECTION("char") {
+        test_fill_pool<char>();
+    }
+}
+
+TEST_CASE("Deallocated objects are not written to", "[BitPool]") {
+    BitPool<TestObject2> bp;
+    auto keep = static_cast<TestObject2*>(bp.allocate());
+    auto obj = static_cast<char*>(bp.allocate());
+    std::memset(obj, 0xAB, sizeof(TestObject2));
+    bp.deallocate(obj);
+    for (size_t i = 0; i < sizeof(TestObject2); ++i) {
+        REQUIRE((unsigned char)obj[i] == 0xAB);
+    }
+    // the lowest free slot is reused
+    REQUIRE(bp.allocate() == obj);
+    bp.deallocate(obj);
+    bp.deallocate(keep);
+    REQUIRE(bp.getNumberOfPools() == 0);
+}
+
+TEST_CASE("Random (de)allocations of a BitPool do not overlap",
+          "[BitPool]") {
+    BitPool<size_t> bp;
+    std::mt19937 gen(42);
+    vector<size_t*> objs;
+    for (size_t i = 0; i < 20000; ++i) {
+        if (objs.empty() || gen() % 3 != 0) {
+            auto obj = static_cast<size_t*>(bp.allocate());
+            *obj = (size_t)obj;
+            objs.push_back(obj);
+        } else {
+            size_t index = gen() % objs.size();
+            REQUIRE(*objs[index] == (size_t)objs[index]);
+            bp.deallocate(objs[index]);
+            objs[index] = objs.back();
+            objs.pop_back();
+        }
+    }
+    std::sort(objs.begin(), objs.end());
+    REQUIRE(std::adjacent_find(objs.begin(), objs.end()) == objs.end());
+    for (auto obj : objs) {
+        REQUIRE(*obj == (size_t)obj);
+        bp.deallocate(obj);
+    }
+    REQUIRE(bp.getNumberOfPools() == 0);
+}
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/BuddyAllocator.hpp"
+using namespace rpools;
+
+TEST_CASE("Blocks are powers of 2 aligned at their size", "[BuddyAllocator]") {
+    BuddyAllocator buddy(1024 * 1024, 4096);
+    for (size_t size : { 1, 4096, 4097, 10000, 65536, 300000 }) {
+        auto ptr = static_cast<char*>(buddy.allocate(size));
+        REQUIRE(ptr != nullptr);
+        size_t blockSize = buddy.getBlockSize(ptr);
+        REQUIRE(blockSize >= size);
+        REQUIRE(blockSize >= buddy.getMinBlockSize());
+        REQUIRE((blockSize & (blockSize - 1)) == 0);
+        REQUIRE((size_t)ptr % getPageSize() == 0);
+        buddy.deallocate(ptr);
+    }
+    REQUIRE(buddy.getFreeBytes() == buddy.getRegionSize());
+}
+
+TEST_CASE("The whole region can be allocated", "[BuddyAllocator]") {
+    BuddyAllocator buddy(1024 * 1024, 4096);
+    size_t blocks = buddy.getRegionSize() / buddy.getMinBlockSize();
+    vector<char*> ptrs;
+    for (size_t i = 0; i < blocks; ++i) {
+        ptrs.push_back(static_cast<char*>(buddy.allocate(4096)));
+        REQUIRE(ptrs.back() != nullptr);
+    }
+    REQUIRE(buddy.getFreeBytes() == 0);
+    REQUIRE(buddy.allocate(1) == nullptr);
+    // the blocks do not overlap
+    std::sort(ptrs.begin(), ptrs.end());
+    for (size_t i = 1; i < ptrs.size(); ++i) {
+        REQUIRE(ptrs[i] - ptrs[i - 1] == 4096);
+    }
+    for (auto ptr : ptrs) {
+        buddy.deallocate(ptr);
+    }
+    // all the buddies were merged back into the region
+    void* region = buddy.allocate(buddy.getRegionSize());
+    REQUIRE(region != nullptr);
+    REQUIRE(buddy.allocate(1) == nullptr);
+    buddy.deallocate(region);
+}
+
+TEST_CASE("Sizes larger than the region are not allocated",
+          "[BuddyAllocator]") {
+    BuddyAllocator buddy(1024 * 1024, 4096);
+    REQUIRE(buddy.allocate(buddy.getRegionSize() + 1) == nullptr);
+    REQUIRE(buddy.allocate(SIZE_MAX) == nullptr);
+    REQUIRE(buddy.getFreeBytes() == buddy.getRegionSize());
+}
+
+TEST_CASE("Buddies are merged in any order", "[BuddyAllocator]") {
+    BuddyAllocator buddy(4 * 1024 * 1024, 4096);
+    std::mt19937 gen(7);
+    vector<void*> ptrs;
+    for (size_t i = 0; i < 200; ++i) {
+        void* ptr = buddy.allocate(size_t(4096) << (gen() % 6));
+        if (ptr) {
+            ptrs.push_back(ptr);
+        }
+    }
+    std::shuffle(ptrs.begin(), ptrs.end(), gen);
+    for (auto ptr : ptrs) {
+        buddy.deallocate(ptr);
+    }
+    REQUIRE(buddy.getFreeBytes() == buddy.getRegionSize());
+    REQUIRE(buddy.allocate(buddy.getRegionSize()) != nullptr);
+}
@@ -1,11 +1,22 @@
 #include "catch.hpp"
 
+#include <set>
 #include <vector>
 using std::vector;
 
 #include "rpools/custom_new/custom_new_delete.hpp"
+#include "rpools/custom_new/size_classes.hpp"
+#include "rpools/allocators/BitPool.hpp"
+#include "rpools/allocators/GlobalLinkedPool.hpp"
 #include "rpools/allocators/NSGlobalLinkedPool.hpp"
+#include "rpools/allocators/TLSF.hpp"
 using rpools::NSGlobalLinkedPool;
+using rpools::PoolHeaderG;
+
+static const rpools::BitPoolHeader& getTinyHeader(void* t_ptr) {
+    return *reinterpret_cast<rpools::BitPoolHeader*>(
+        reinterpret_cast<size_t>(t_ptr) & rpools::getPoolMask());
+}
 
 TEST_CASE("Allocations between 0 and 128 bytes have correct alignment",
           "[custom_new_delete]") {
@@ -21,20 +32,16 @@ TEST_CASE("Pointers to objects of size < 129 are deallocated using GlobalLinkedP
     for (size_t i = 0; i <= 128; ++i) {
         allocs[i] = custom_new_no_throw(i, sizeof(void*));
     }
-    size_t index = allocs.size() - 1;
     for (size_t i = allocs.size(); i > 0; --i) {
+        const PoolHeaderG& header =
+            NSGlobalLinkedPool::getPoolHeader(allocs[i-1]);
+        size_t oldSize = header.occupiedSlots;
+        custom_delete(allocs[i-1]);
         // we do not want to deal with dangling references
         // because our pool header will get destroyed once we
         // deallocate the last object of the pool
-        if ((i - 1) % 8 == 1) {
-            custom_delete(allocs[i-1]);
-            index = i - 2;
-        } else {
-            size_t oldSize =
-                NSGlobalLinkedPool::getPoolHeader(allocs[i-1]).occupiedSlots;
-            custom_delete(allocs[i-1]);
-            REQUIRE(oldSize - 1 ==
-                    NSGlobalLinkedPool::getPoolHeader(allocs[index]).occupiedSlots);
+        if (oldSize > 1) {
+            REQUIRE(oldSize - 1 == header.occupiedSlots);
         }
     }
 }
@@ -51,3 +58,185 @@ TEST_CASE("121 aligned at 16 bytes will get allocated into a pool of size 128",
     REQUIRE((size_t)res % 16 == 0);
     REQUIRE(NSGlobalLinkedPool::getPoolHeader(res).sizeOfSlot == 128);
 }
+
+TEST_CASE("custom_new_class allocates in the same pool as custom_new",
+          "[custom_new_delete]") {
+    for (size_t i = 0; i <= rpools::CUSTOM_NEW_THRESHOLD; ++i) {
+        for (size_t align : { sizeof(void*), alignof(max_align_t) }) {
+            void* expected = custom_new(i, align);
+            void* res = custom_new_class(rpools::getSizeClass(i, align));
+            REQUIRE((size_t)res % align == 0);
+            REQUIRE(NSGlobalLinkedPool::getPoolHeader(res).sizeOfSlot ==
+                    NSGlobalLinkedPool::getPoolHeader(expected).sizeOfSlot);
+            custom_delete(res);
+            custom_delete(expected);
+        }
+    }
+}
+
+TEST_CASE("custom_new_typed gives hot types a pool of their own",
+          "[custom_new_delete]") {
+    const size_t sizeClass = rpools::getSizeClass(24, sizeof(void*));
+    const size_t typeId = 0x5eed;
+    vector<void*> objects;
+    // the first allocations share the pool of the size class
+    void* first = custom_new_typed(sizeClass, typeId);
+    void* untyped = custom_new_class(sizeClass);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(first).owner ==
+            NSGlobalLinkedPool::getPoolHeader(untyped).owner);
+    objects.push_back(first);
+    for (size_t i = 0; i < 256; ++i) {
+        objects.push_back(custom_new_typed(sizeClass, typeId));
+    }
+    void* hot = objects.back();
+    REQUIRE((size_t)hot % sizeof(void*) == 0);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(hot).sizeOfSlot == 24);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(hot).owner !=
+            NSGlobalLinkedPool::getPoolHeader(untyped).owner);
+    // other size classes of the same type use the pool of the class
+    void* array = custom_new_typed(rpools::getSizeClass(96, 16), typeId);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(array).sizeOfSlot == 96);
+    custom_delete(array);
+    custom_delete(untyped);
+    for (void* object : objects) {
+        custom_delete(object);
+    }
+}
+
+TEST_CASE("custom_delete_sized frees pool and malloc-d allocations",
+          "[custom_new_delete]") {
+    void* keep = custom_new(64);
+    void* small = custom_new(64);
+    size_t occupied = NSGlobalLinkedPool::getPoolHeader(keep).occupiedSlots;
+    custom_delete_sized(small, 64);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(keep).occupiedSlots ==
+            occupied - 1);
+    // the freed slot is reused
+    REQUIRE(custom_new(64) == small);
+    custom_delete_sized(small, 64);
+    custom_delete(keep);
+    void* large = custom_new(rpools::CUSTOM_NEW_THRESHOLD + 1);
+    custom_delete_sized(large, rpools::CUSTOM_NEW_THRESHOLD + 1);
+}
+
+TEST_CASE("Registering a manifest reserves pages for its size classes",
+          "[custom_new_delete]") {
+    const size_t sizeClass = rpools::getSizeClass(112, alignof(max_align_t));
+    size_t sites[rpools::NUM_OF_SIZE_CLASSES] = {};
+    sites[sizeClass] = 20;
+    custom_new_register_manifest(sites, rpools::NUM_OF_SIZE_CLASSES);
+    void* ptr = custom_new_class(sizeClass);
+    auto& pool = *static_cast<rpools::GlobalLinkedPool*>(
+        NSGlobalLinkedPool::getPoolHeader(ptr).owner);
+    // 20 sites reserve 2 pages, one of which is used by ptr
+    REQUIRE(pool.getNumberOfPools() == 2);
+    custom_delete(ptr);
+}
+
+TEST_CASE("Short-lived objects do not share pages with long-lived objects",
+          "[custom_new_delete]") {
+    const size_t sizeClass = rpools::getSizeClass(40, sizeof(void*));
+    void* longLived = custom_new_class(sizeClass);
+    void* shortLived = custom_new_lifetime(sizeClass, rpools::SHORT_LIVED);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(shortLived).sizeOfSlot == 40);
+    REQUIRE(&NSGlobalLinkedPool::getPoolHeader(shortLived) !=
+            &NSGlobalLinkedPool::getPoolHeader(longLived));
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(shortLived).owner !=
+            NSGlobalLinkedPool::getPoolHeader(longLived).owner);
+    // the long-lived pool is used by default
+    void* other = custom_new_lifetime(sizeClass, rpools::LONG_LIVED);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(other).owner ==
+            NSGlobalLinkedPool::getPoolHeader(longLived).owner);
+    custom_delete(other);
+    custom_delete(shortLived);
+    custom_delete(longLived);
+}
+
+TEST_CASE("Mid-size allocations are made in TLSF", "[custom_new_delete]") {
+    vector<void*> ptrs;
+    for (size_t size = rpools::CUSTOM_NEW_THRESHOLD + 1; size <= 4096;
+         size += 97) {
+        void* ptr = custom_new(size);
+        REQUIRE((size_t)ptr % alignof(max_align_t) == 0);
+        REQUIRE(rpools::TLSF::getBlockSize((char*)ptr - 16) >= size + 16);
+        ptrs.push_back(ptr);
+    }
+    for (auto ptr : ptrs) {
+        custom_delete(ptr);
+    }
+    // freed blocks are reused
+    void* ptr = custom_new(1000);
+    custom_delete_sized(ptr, 1000);
+    REQUIRE(custom_new(1000) == ptr);
+    custom_delete(ptr);
+}
+
+TEST_CASE("Tiny allocations are made in bitmap pages of their size",
+          "[custom_new_delete]") {
+    for (size_t size = 1; size <= rpools::TINY_THRESHOLD; ++size) {
+        size_t slot = size == 3 ? 4 : size;
+        void* first = custom_new(size, 1);
+        void* second = custom_new(size, 1);
+        REQUIRE(getTinyHeader(first).sizeOfSlot == slot);
+        REQUIRE((size_t)first % slot == 0);
+        // the slots are packed without any free list nodes
+        REQUIRE((char*)second - (char*)first == (ptrdiff_t)slot);
+        size_t occupied = getTinyHeader(first).occupiedSlots;
+        custom_delete(second);
+        REQUIRE(getTinyHeader(first).occupiedSlots == occupied - 1);
+        // the freed slot is reused
+        REQUIRE(custom_new(size, 1) == second);
+        custom_delete_sized(second, size);
+        custom_delete(first);
+    }
+}
+
+TEST_CASE("Tiny allocations with larger alignments use the size classes",
+          "[custom_new_delete]") {
+    void* ptr = custom_new(2, sizeof(void*));
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(ptr).sizeOfSlot ==
+            sizeof(void*));
+    custom_delete_sized(ptr, 2, sizeof(void*));
+}
+
+TEST_CASE("operator new makes tiny allocations in the tiny classes",
+          "[custom_new_delete]") {
+    bool* flag = new bool(true);
+    int* number = new int(42);
+    REQUIRE(getTinyHeader(flag).sizeOfSlot == sizeof(bool));
+    REQUIRE(getTinyHeader(number).sizeOfSlot == sizeof(int));
+    REQUIRE((size_t)number % alignof(int) == 0);
+    delete flag;
+    delete number;
+}
+
+TEST_CASE("Tiny allocations use less memory than the smallest size class",
+          "[custom_new_delete]") {
+    const size_t count = 4096;
+    vector<void*> ptrs;
+    std::set<size_t> pages;
+    for (size_t i = 0; i < count; ++i) {
+        ptrs.push_back(custom_new(1, 1));
+        pages.insert((size_t)ptrs.back() & rpools::getPoolMask());
+    }
+    // 8 byte slots would need at least this many pages
+    size_t classPages = count * sizeof(void*) / rpools::getPageSize();
+    REQUIRE(pages.size() * 2 <= classPages);
+    for (void* ptr : ptrs) {
+        custom_delete(ptr);
+    }
+}
+
+TEST_CASE("operator new uses the natural alignment of the size",
+          "[custom_new_delete]") {
+    REQUIRE(rpools::getNaturalAlignment(1) == 1);
+    REQUIRE(rpools::getNaturalAlignment(3) == 2);
+    REQUIRE(rpools::getNaturalAlignment(8) == 8);
+    REQUIRE(rpools::getNaturalAlignment(24) == 16);
+    REQUIRE(rpools::getNaturalAlignment(0) == alignof(max_align_t));
+    // an 8 byte object does not need a 16 byte slot
+    double* number = new double(1.0);
+    REQUIRE(NSGlobalLinkedPool::getPoolHeader(number).sizeOfSlot ==
+            sizeof(double));
+    delete number;
+}
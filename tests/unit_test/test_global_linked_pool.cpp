@@ -6,6 +6,8 @@
 #include "rpools/allocators/NSGlobalLinkedPool.hpp"
 using namespace rpools;
 
+#include <algorithm>
+#include <set>
 #include <thread>
 #include <mutex>
 #include <vector>
@@ -242,3 +244,131 @@ TEST_CASE("Pools are synchronized", "[GlobalLinkedPool]") {
         test_pools_are_syncrhonized<TestObject2>();
     }
 }
+
+TEST_CASE("Reserved pools are used before new pools are created",
+          "[GlobalLinkedPool]") {
+    GlobalLinkedPool glp(sizeof(TestObject), alignof(TestObject));
+    glp.reserve(3);
+    REQUIRE(glp.getNumberOfPools() == 3);
+    // reserving fewer pages than there are free pages does nothing
+    glp.reserve(2);
+    REQUIRE(glp.getNumberOfPools() == 3);
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < glp.getPoolSize(); ++i) {
+        ptrs.push_back(glp.allocate());
+    }
+    // the full page is no longer free
+    REQUIRE(glp.getNumberOfPools() == 2);
+    for (auto ptr : ptrs) {
+        glp.deallocate(ptr);
+    }
+    // the page is freed with its last object
+    REQUIRE(glp.getNumberOfPools() == 2);
+    glp.releaseAll();
+}
+
+static size_t destroyedSlots = 0;
+
+TEST_CASE("releaseAll and destroyAll free every page",
+          "[GlobalLinkedPool]") {
+    GlobalLinkedPool glp(32, alignof(max_align_t), true);
+    size_t size = glp.getPoolSize();
+    vector<void*> objs;
+    for (size_t i = 0; i < 2 * size + 5; ++i) {
+        objs.push_back(glp.allocate());
+    }
+    size_t live = objs.size();
+    for (size_t i = 0; i < objs.size(); i += 3) {
+        glp.deallocate(objs[i]);
+        --live;
+    }
+    glp.destroyAll([](void*) { ++destroyedSlots; });
+    REQUIRE(destroyedSlots == live);
+    REQUIRE(glp.getNumberOfPools() == 0);
+
+    // the pool can be used again
+    REQUIRE(glp.allocate() != nullptr);
+    REQUIRE(glp.getNumberOfPools() == 1);
+    glp.releaseAll();
+    REQUIRE(glp.getNumberOfPools() == 0);
+}
+
+TEST_CASE("forEachLive visits every allocated slot in address order",
+          "[GlobalLinkedPool]") {
+    GlobalLinkedPool glp(48, alignof(max_align_t), true);
+    vector<void*> objs;
+    for (size_t i = 0; i < 3 * glp.getPoolSize(); ++i) {
+        objs.push_back(glp.allocate());
+    }
+    vector<void*> live;
+    for (size_t i = 0; i < objs.size(); ++i) {
+        if (i % 4 == 0) {
+            glp.deallocate(objs[i]);
+        } else {
+            live.push_back(objs[i]);
+        }
+    }
+    std::sort(live.begin(), live.end());
+    vector<void*> visited;
+    glp.forEachLive([&](void* t_ptr) { visited.push_back(t_ptr); });
+    REQUIRE(visited == live);
+    glp.releaseAll();
+}
+
+TEST_CASE("compact evacuates the sparsest pages", "[GlobalLinkedPool]") {
+    GlobalLinkedPool glp(sizeof(size_t) * 4, alignof(max_align_t), true);
+    size_t size = glp.getPoolSize();
+    vector<size_t*> table;
+    for (size_t i = 0; i < 5 * size; ++i) {
+        auto obj = static_cast<size_t*>(glp.allocate());
+        obj[0] = i;
+        table.push_back(obj);
+    }
+    // the first page stays full, the other pages become sparse
+    size_t live = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (i >= size && i % 3 != 0) {
+            glp.deallocate(table[i]);
+            table[i] = nullptr;
+        } else {
+            ++live;
+        }
+    }
+    size_t freed = glp.compact([&](void* t_from, void* t_to) {
+        size_t id = *static_cast<size_t*>(t_from);
+        *static_cast<size_t*>(t_to) = id;
+        table[id] = static_cast<size_t*>(t_to);
+    });
+    REQUIRE(freed > 0);
+    std::set<size_t> pages;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (table[i]) {
+            REQUIRE(table[i][0] == i);
+            pages.insert((size_t)table[i] & getPoolMask());
+        }
+    }
+    REQUIRE(pages.size() == (live + size - 1) / size);
+    glp.releaseAll();
+}
+
+TEST_CASE("Only pools which track their slots can be scanned",
+          "[GlobalLinkedPool]") {
+    GlobalLinkedPool untracked(sizeof(size_t), alignof(size_t));
+    GlobalLinkedPool tracked(sizeof(size_t), alignof(size_t), true);
+    // the bitmap follows the header of a tracked page
+    size_t bitmap = (tracked.getPoolSize() + 63) / 64 * sizeof(uint64_t);
+    REQUIRE(sizeof(PoolHeaderG) + bitmap +
+            tracked.getPoolSize() * sizeof(size_t) <= (size_t)getPageSize());
+    REQUIRE(tracked.getPoolSize() < untracked.getPoolSize());
+    REQUIRE_THROWS_AS(untracked.forEachLive([](void*) {}),
+                      std::logic_error);
+
+    // every slot of the page is tracked
+    for (size_t i = 0; i < tracked.getPoolSize(); ++i) {
+        tracked.allocate();
+    }
+    size_t visited = 0;
+    tracked.forEachLive([&](void*) { ++visited; });
+    REQUIRE(visited == tracked.getPoolSize());
+    tracked.releaseAll();
+}
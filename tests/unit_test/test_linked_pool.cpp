@@ -1,5 +1,8 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <set>
+
 #include "TestObject.h"
 #include "TestObject2.h"
 #include "rpools/allocators/LinkedPool.hpp"
@@ -8,7 +11,13 @@ using namespace rpools;
 template<typename T>
 void test_pool_size() {
     LinkedPool<T> lp;
-    size_t expectedSize = (getPageSize() - sizeof(PoolHeader)) / sizeof(T);
+    size_t pageSize = getPageSize();
+    size_t expectedSize = (pageSize - sizeof(PoolHeader)) / sizeof(T);
+    // the bitmap of the allocated slots follows the header
+    while (sizeof(PoolHeader) + OccupancyMap::getWords(expectedSize) *
+           sizeof(uint64_t) + expectedSize * sizeof(T) > pageSize) {
+        --expectedSize;
+    }
     REQUIRE(lp.getPoolSize() == expectedSize);
 }
 
@@ -167,3 +176,122 @@ TEST_CASE("A new pool allocates iff all the other pools are full", "[LinkedPool]
         test_pools_fill_up<TestObject2>();
     }
 }
+
+/** Counts how many times it is destroyed. */
+struct Destroyed {
+    static size_t count;
+    size_t x[3];
+    ~Destroyed() { ++count; }
+};
+size_t Destroyed::count = 0;
+
+TEST_CASE("releaseAll and destroyAll free every page", "[LinkedPool]") {
+    LinkedPool<Destroyed> lp;
+    size_t size = lp.getPoolSize();
+    vector<Destroyed*> objs;
+    for (size_t i = 0; i < 2 * size + 5; ++i) {
+        objs.push_back(new (lp.allocate()) Destroyed());
+    }
+    // leave holes in the first pages
+    size_t live = objs.size();
+    for (size_t i = 0; i < objs.size(); i += 3) {
+        objs[i]->~Destroyed();
+        lp.deallocate(objs[i]);
+        --live;
+    }
+    Destroyed::count = 0;
+    lp.destroyAll();
+    REQUIRE(Destroyed::count == live);
+    REQUIRE(lp.getNumberOfPools() == 0);
+
+    // the pool can be used again
+    lp.allocate();
+    REQUIRE(lp.getNumberOfPools() == 1);
+    Destroyed::count = 0;
+    lp.releaseAll();
+    REQUIRE(Destroyed::count == 0);
+    REQUIRE(lp.getNumberOfPools() == 0);
+}
+
+TEST_CASE("forEachLive visits every allocated object in address order",
+          "[LinkedPool]") {
+    LinkedPool<TestObject2> lp;
+    vector<TestObject2*> objs;
+    for (size_t i = 0; i < 3 * lp.getPoolSize(); ++i) {
+        objs.push_back(static_cast<TestObject2*>(lp.allocate()));
+    }
+    vector<TestObject2*> live;
+    for (size_t i = 0; i < objs.size(); ++i) {
+        if (i % 4 == 0) {
+            lp.deallocate(objs[i]);
+        } else {
+            live.push_back(objs[i]);
+        }
+    }
+    std::sort(live.begin(), live.end());
+    vector<TestObject2*> visited;
+    lp.forEachLive([&](TestObject2* t_obj) { visited.push_back(t_obj); });
+    REQUIRE(visited == live);
+    lp.releaseAll();
+    visited.clear();
+    lp.forEachLive([&](TestObject2* t_obj) { visited.push_back(t_obj); });
+    REQUIRE(visited.empty());
+}
+
+/** An object which knows its own index in the table of pointers. */
+struct Relocatable {
+    size_t id;
+    size_t payload[2];
+};
+
+TEST_CASE("compact evacuates the sparsest pages", "[LinkedPool]") {
+    LinkedPool<Relocatable> lp;
+    size_t size = lp.getPoolSize();
+    vector<Relocatable*> table;
+    for (size_t i = 0; i < 6 * size; ++i) {
+        auto obj = new (lp.allocate()) Relocatable();
+        obj->id = i;
+        obj->payload[0] = i * 3;
+        table.push_back(obj);
+    }
+    // keep every 4th object, so every page is sparse
+    size_t live = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (i % 4 != 0) {
+            lp.deallocate(table[i]);
+            table[i] = nullptr;
+        } else {
+            ++live;
+        }
+    }
+    auto relocate = [&](Relocatable* t_from, Relocatable* t_to) {
+        new (t_to) Relocatable(*t_from);
+        table[t_from->id] = t_to;
+    };
+
+    SECTION("with a budget the pages are evacuated incrementally") {
+        // a page holds about size / 4 objects
+        size_t freed = lp.compact(relocate, size / 2);
+        REQUIRE(freed >= 1);
+        REQUIRE(freed <= 2);
+        while (lp.compact(relocate, size / 2) > 0) {}
+    }
+    SECTION("without a budget the pages are evacuated at once") {
+        REQUIRE(lp.compact(relocate) > 0);
+        REQUIRE(lp.compact(relocate) == 0);
+    }
+
+    std::set<size_t> pages;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (table[i]) {
+            REQUIRE(table[i]->id == i);
+            REQUIRE(table[i]->payload[0] == i * 3);
+            pages.insert((size_t)table[i] & getPoolMask());
+        }
+    }
+    REQUIRE(pages.size() == (live + size - 1) / size);
+    size_t visited = 0;
+    lp.forEachLive([&](Relocatable*) { ++visited; });
+    REQUIRE(visited == live);
+    lp.releaseAll();
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/LockFreeMemoryPool.hpp"
+using rpools::LockFreeMemoryPool;
+
+struct Tagged {
+    size_t owner;
+    size_t index;
+};
+
+TEST_CASE("Allocated objects are distinct and freed slots are reused",
+          "[LockFreeMemoryPool]") {
+    LockFreeMemoryPool<Tagged> pool;
+    vector<Tagged*> objs;
+    // more than one block
+    for (size_t i = 0; i < 1000; ++i) {
+        objs.push_back(pool.allocate());
+        REQUIRE((size_t)objs.back() % alignof(Tagged) == 0);
+    }
+    REQUIRE(pool.getNumberOfBlocks() > 1);
+    vector<Tagged*> sorted(objs);
+    std::sort(sorted.begin(), sorted.end());
+    REQUIRE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+    size_t blocks = pool.getNumberOfBlocks();
+    for (auto obj : objs) {
+        pool.deallocate(obj);
+    }
+    // the free slots are a stack
+    REQUIRE(pool.allocate() == objs.back());
+    for (size_t i = 1; i < objs.size(); ++i) {
+        pool.allocate();
+    }
+    REQUIRE(pool.getNumberOfBlocks() == blocks);
+}
+
+TEST_CASE("Threads never get the same slot", "[LockFreeMemoryPool]") {
+    const size_t threadsNo = 4;
+    const size_t objects = 2000;
+    LockFreeMemoryPool<Tagged> pool;
+    vector<size_t> errors(threadsNo, 0);
+    vector<std::thread> threads;
+    for (size_t t = 0; t < threadsNo; ++t) {
+        threads.emplace_back([&pool, &errors, t, objects]() {
+            vector<Tagged*> objs(objects);
+            for (size_t round = 0; round < 50; ++round) {
+                for (size_t i = 0; i < objects; ++i) {
+                    objs[i] = pool.allocate();
+                    objs[i]->owner = t;
+                    objs[i]->index = i;
+                }
+                // another thread would have overwritten a shared slot
+                for (size_t i = 0; i < objects; ++i) {
+                    if (objs[i]->owner != t || objs[i]->index != i) {
+                        ++errors[t];
+                    }
+                    pool.deallocate(objs[i]);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t t = 0; t < threadsNo; ++t) {
+        REQUIRE(errors[t] == 0);
+    }
+}
+
+struct alignas(64) Wide {
+    char bytes[64];
+};
+
+TEST_CASE("Over-aligned objects are aligned", "[LockFreeMemoryPool]") {
+    LockFreeMemoryPool<Wide> pool;
+    vector<Wide*> objs;
+    for (size_t i = 0; i < 200; ++i) {
+        objs.push_back(pool.allocate());
+        REQUIRE((size_t)objs.back() % alignof(Wide) == 0);
+    }
+    REQUIRE(pool.getNumberOfBlocks() > 1);
+    for (auto obj : objs) {
+        pool.deallocate(obj);
+    }
+}
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/MemoryPool.h"
+
+/** Counts how many times it is destroyed. */
+struct Destroyed {
+    static size_t count;
+    size_t x[3];
+    ~Destroyed() { ++count; }
+};
+size_t Destroyed::count = 0;
+
+TEST_CASE("destroyAll destroys only the allocated elements", "[MemoryPool]") {
+    MemoryPool<Destroyed> pool;
+    vector<Destroyed*> objs;
+    // more than one block
+    for (size_t i = 0; i < 500; ++i) {
+        objs.push_back(pool.newElement());
+    }
+    size_t live = objs.size();
+    for (size_t i = 0; i < objs.size(); i += 3) {
+        pool.deleteElement(objs[i]);
+        --live;
+    }
+    Destroyed::count = 0;
+    pool.destroyAll();
+    REQUIRE(Destroyed::count == live);
+    // the pool can be used again
+    Destroyed* obj = pool.newElement();
+    REQUIRE(obj != nullptr);
+    pool.deleteElement(obj);
+}
+
+TEST_CASE("releaseAll does not destroy the elements", "[MemoryPool]") {
+    MemoryPool<Destroyed> pool;
+    for (size_t i = 0; i < 500; ++i) {
+        pool.newElement();
+    }
+    Destroyed::count = 0;
+    pool.releaseAll();
+    REQUIRE(Destroyed::count == 0);
+    REQUIRE(pool.newElement() != nullptr);
+}
+
+TEST_CASE("Empty blocks are released", "[MemoryPool]") {
+    MemoryPool<Destroyed> pool;
+    vector<Destroyed*> objs;
+    for (size_t i = 0; i < 2000; ++i) {
+        objs.push_back(pool.allocate());
+    }
+    size_t blocks = pool.getNumberOfBlocks();
+    REQUIRE(blocks > 2);
+    // keep a single element of the first block alive
+    for (size_t i = 1; i < objs.size(); ++i) {
+        pool.deallocate(objs[i]);
+    }
+    REQUIRE(pool.getNumberOfBlocks() <= 2);
+    // the freed slots of the remaining blocks are reused
+    Destroyed* obj = pool.allocate();
+    REQUIRE(std::find(objs.begin(), objs.end(), obj) != objs.end());
+    pool.deallocate(obj);
+    pool.deallocate(objs[0]);
+    REQUIRE(pool.getNumberOfBlocks() <= 1);
+    // the pool can be used again after its blocks are released
+    for (size_t i = 0; i < 2000; ++i) {
+        objs[i] = pool.allocate();
+    }
+    REQUIRE(pool.getNumberOfBlocks() == blocks);
+    for (auto ptr : objs) {
+        pool.deallocate(ptr);
+    }
+}
+
+TEST_CASE("The block size is a template parameter", "[MemoryPool]") {
+    const size_t blockSize = 64 * 1024;
+    MemoryPool<Destroyed, blockSize> large;
+    MemoryPool<Destroyed> small;
+    vector<Destroyed*> objs;
+    for (size_t i = 0; i < 2000; ++i) {
+        objs.push_back(large.allocate());
+        small.deallocate(small.allocate());
+    }
+    REQUIRE(large.getNumberOfBlocks() == 1);
+    // every element is in the block of the first one
+    for (auto ptr : objs) {
+        REQUIRE(((size_t)ptr & ~(blockSize - 1)) ==
+                ((size_t)objs[0] & ~(blockSize - 1)));
+    }
+    for (auto ptr : objs) {
+        large.deallocate(ptr);
+    }
+    REQUIRE(small.getNumberOfBlocks() == 1);
+}
@@ -0,0 +1,88 @@
+#include "catch.hpp"
+
+#include <cstring>
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/MonotonicArena.hpp"
+using namespace rpools;
+
+TEST_CASE("Allocations of a MonotonicArena are aligned and do not overlap",
+          "[MonotonicArena]") {
+    MonotonicArena arena(1);
+    vector<char*> ptrs;
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t alignment = size_t(1) << (i % 7);
+        auto ptr = static_cast<char*>(arena.allocate(i % 100 + 1, alignment));
+        REQUIRE(ptr != nullptr);
+        REQUIRE((size_t)ptr % alignment == 0);
+        std::memset(ptr, (int)(i % 256), i % 100 + 1);
+        ptrs.push_back(ptr);
+    }
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+        for (size_t j = 0; j < i % 100 + 1; ++j) {
+            REQUIRE(ptrs[i][j] == (char)(i % 256));
+        }
+    }
+    REQUIRE(arena.getNumberOfChunks() > 1);
+}
+
+TEST_CASE("Reset keeps the chunks for the next allocations",
+          "[MonotonicArena]") {
+    MonotonicArena arena(1);
+    REQUIRE(arena.getNumberOfChunks() == 0);
+    void* first = arena.allocate(64);
+    for (size_t i = 0; i < 200; ++i) {
+        arena.allocate(64);
+    }
+    size_t chunks = arena.getNumberOfChunks();
+    REQUIRE(chunks > 1);
+    arena.reset();
+    REQUIRE(arena.allocate(64) == first);
+    for (size_t i = 0; i < 200; ++i) {
+        arena.allocate(64);
+    }
+    REQUIRE(arena.getNumberOfChunks() == chunks);
+    arena.release();
+    REQUIRE(arena.getNumberOfChunks() == 0);
+}
+
+TEST_CASE("Large allocations get a chunk of their own", "[MonotonicArena]") {
+    MonotonicArena arena(1);
+    void* small = arena.allocate(16);
+    size_t size = 4 * getPageSize();
+    auto large = static_cast<char*>(arena.allocate(size));
+    REQUIRE(large != nullptr);
+    std::memset(large, 1, size);
+    REQUIRE(arena.getNumberOfChunks() == 2);
+    arena.reset();
+    REQUIRE(arena.allocate(16) == small);
+    // the large chunk is reused after the first one
+    REQUIRE(arena.allocate(size) == large);
+    REQUIRE(arena.getNumberOfChunks() == 2);
+}
+
+TEST_CASE("Nested scopes free their own allocations", "[MonotonicArena]") {
+    MonotonicArena arena(1);
+    void* outer = arena.allocate(32);
+    void* inner = nullptr;
+    {
+        MonotonicArena::Scope scope(arena);
+        inner = arena.allocate(32);
+        {
+            MonotonicArena::Scope nested(arena);
+            // fill the first chunk so that the nested scope moves on
+            for (size_t i = 0; i < 200; ++i) {
+                arena.allocate(32);
+            }
+        }
+        REQUIRE(arena.allocate(32) == static_cast<char*>(inner) + 32);
+        MonotonicArena::Marker marker = arena.mark();
+        void* ptr = arena.allocate(32);
+        arena.rewind(marker);
+        REQUIRE(arena.allocate(32) == ptr);
+    }
+    REQUIRE(arena.allocate(32) == inner);
+    arena.reset();
+    REQUIRE(arena.allocate(32) == outer);
+}
@@ -0,0 +1,114 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/ObjectCache.hpp"
+using namespace rpools;
+
+/** Counts how many times it is constructed and destroyed. */
+struct Counted {
+    static size_t constructed;
+    static size_t destroyed;
+    vector<int> values;
+    Counted() {
+        ++constructed;
+        values.reserve(16);
+    }
+    ~Counted() { ++destroyed; }
+};
+size_t Counted::constructed = 0;
+size_t Counted::destroyed = 0;
+
+struct alignas(64) Aligned {
+    char data[40];
+};
+
+void resetCounts() {
+    Counted::constructed = 0;
+    Counted::destroyed = 0;
+}
+
+TEST_CASE("Objects are constructed once when the page is carved",
+          "[ObjectCache]") {
+    resetCounts();
+    ObjectCache<Counted> cache;
+    Counted* obj = cache.allocate();
+    REQUIRE(Counted::constructed == cache.getPoolSize());
+    REQUIRE(cache.getNumberOfPools() == 1);
+    // the rest of the page is already constructed
+    vector<Counted*> objs;
+    for (size_t i = 1; i < cache.getPoolSize(); ++i) {
+        objs.push_back(cache.allocate());
+    }
+    REQUIRE(Counted::constructed == cache.getPoolSize());
+    REQUIRE(cache.getNumberOfPools() == 1);
+    for (auto o : objs) {
+        cache.deallocate(o);
+    }
+    cache.deallocate(obj);
+    REQUIRE(Counted::destroyed == 0);
+}
+
+TEST_CASE("Deallocated objects are returned constructed", "[ObjectCache]") {
+    resetCounts();
+    ObjectCache<Counted> cache;
+    Counted* obj = cache.allocate();
+    REQUIRE(obj->values.capacity() >= 16);
+    obj->values.push_back(42);
+    obj->values.clear();
+    int* data = obj->values.data();
+    cache.deallocate(obj);
+    Counted* again = cache.allocate();
+    REQUIRE(again == obj);
+    // the embedded vector kept its buffer
+    REQUIRE(again->values.data() == data);
+    cache.deallocate(again);
+    REQUIRE(Counted::destroyed == 0);
+}
+
+TEST_CASE("Objects are destroyed when their page is reclaimed",
+          "[ObjectCache]") {
+    resetCounts();
+    {
+        ObjectCache<Counted> cache;
+        size_t size = cache.getPoolSize();
+        vector<Counted*> objs;
+        for (size_t i = 0; i < 2 * size; ++i) {
+            objs.push_back(cache.allocate());
+        }
+        REQUIRE(cache.getNumberOfPools() == 2);
+        REQUIRE(cache.getNumberOfEmptyPools() == 0);
+        // empty the first page and keep an object of the second one
+        for (size_t i = 0; i < 2 * size - 1; ++i) {
+            cache.deallocate(objs[i]);
+        }
+        REQUIRE(cache.getNumberOfEmptyPools() == 1);
+        REQUIRE(Counted::destroyed == 0);
+        REQUIRE(cache.reclaim() == 1);
+        REQUIRE(Counted::destroyed == size);
+        REQUIRE(cache.getNumberOfPools() == 1);
+        REQUIRE(cache.getNumberOfEmptyPools() == 0);
+        // the remaining page is reused
+        Counted* obj = cache.allocate();
+        REQUIRE(cache.getNumberOfPools() == 1);
+        cache.deallocate(obj);
+        cache.deallocate(objs.back());
+    }
+    // the cache destroys the objects of its remaining pages
+    REQUIRE(Counted::destroyed == Counted::constructed);
+}
+
+TEST_CASE("Objects of an ObjectCache are aligned", "[ObjectCache]") {
+    ObjectCache<Aligned> cache;
+    vector<Aligned*> objs;
+    for (size_t i = 0; i < 2 * cache.getPoolSize(); ++i) {
+        objs.push_back(cache.allocate());
+        REQUIRE((size_t)objs.back() % alignof(Aligned) == 0);
+        REQUIRE(((size_t)objs.back() & getPoolMask()) ==
+                ((size_t)(objs.back() + 1) - 1 & getPoolMask()));
+    }
+    for (auto obj : objs) {
+        cache.deallocate(obj);
+    }
+}
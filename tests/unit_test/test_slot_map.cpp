@@ -0,0 +1,83 @@
+#include "catch.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/SlotMap.hpp"
+using namespace rpools;
+
+using Handle = SlotMap<std::string>::Handle;
+
+TEST_CASE("Handles give access to their objects", "[SlotMap]") {
+    SlotMap<std::string> map;
+    vector<Handle> handles;
+    for (size_t i = 0; i < 1000; ++i) {
+        handles.push_back(map.insert(std::to_string(i)));
+    }
+    REQUIRE(map.size() == 1000);
+    for (size_t i = 0; i < handles.size(); ++i) {
+        REQUIRE(map.contains(handles[i]));
+        REQUIRE(*map.get(handles[i]) == std::to_string(i));
+    }
+}
+
+TEST_CASE("Handles of erased objects are stale", "[SlotMap]") {
+    SlotMap<std::string> map;
+    Handle first = map.insert("first");
+    Handle second = map.insert("second");
+    REQUIRE(map.erase(first));
+    REQUIRE_FALSE(map.contains(first));
+    REQUIRE(map.get(first) == nullptr);
+    REQUIRE_FALSE(map.erase(first));
+    // the slot is reused with a new generation
+    Handle third = map.insert("third");
+    REQUIRE(third.index == first.index);
+    REQUIRE(third != first);
+    REQUIRE(map.get(first) == nullptr);
+    REQUIRE(*map.get(third) == "third");
+    REQUIRE(*map.get(second) == "second");
+    // handles which were never returned are stale too
+    REQUIRE_FALSE(map.contains({ 100, 1 }));
+    REQUIRE_FALSE(map.contains({ third.index, 0 }));
+}
+
+TEST_CASE("Objects keep their address", "[SlotMap]") {
+    SlotMap<std::string> map;
+    Handle handle = map.insert("stable");
+    std::string* ptr = map.get(handle);
+    vector<Handle> others;
+    for (size_t i = 0; i < 1000; ++i) {
+        others.push_back(map.insert("other"));
+    }
+    for (size_t i = 0; i < others.size(); i += 2) {
+        map.erase(others[i]);
+    }
+    REQUIRE(map.get(handle) == ptr);
+}
+
+TEST_CASE("Iteration visits every object once", "[SlotMap]") {
+    SlotMap<std::string> map;
+    vector<Handle> handles;
+    for (size_t i = 0; i < 100; ++i) {
+        handles.push_back(map.insert(std::to_string(i)));
+    }
+    std::set<std::string> expected;
+    for (size_t i = 0; i < handles.size(); ++i) {
+        if (i % 3 == 0) {
+            map.erase(handles[i]);
+        } else {
+            expected.insert(std::to_string(i));
+        }
+    }
+    std::set<std::string> visited;
+    for (auto& str : map) {
+        REQUIRE(visited.insert(str).second);
+    }
+    REQUIRE(visited == expected);
+    REQUIRE(map.size() == expected.size());
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE_FALSE(map.contains(handles[1]));
+}
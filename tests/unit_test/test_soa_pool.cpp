@@ -0,0 +1,85 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/SoAPool.hpp"
+using namespace rpools;
+
+using Particles = SoAPool<float, double, uint8_t>;
+
+TEST_CASE("Fields of different objects do not overlap", "[SoAPool]") {
+    Particles pool;
+    vector<size_t> indices;
+    for (size_t i = 0; i < 3 * Particles::CHUNK_SIZE; ++i) {
+        size_t index = pool.allocate();
+        pool.get<0>(index) = (float)i;
+        pool.get<1>(index) = 2.0 * i;
+        pool.get<2>(index) = (uint8_t)i;
+        indices.push_back(index);
+    }
+    REQUIRE(pool.size() == indices.size());
+    REQUIRE(pool.getNumberOfChunks() == 3);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        REQUIRE(pool.isLive(indices[i]));
+        REQUIRE(pool.get<0>(indices[i]) == (float)i);
+        REQUIRE(pool.get<1>(indices[i]) == 2.0 * i);
+        REQUIRE(pool.get<2>(indices[i]) == (uint8_t)i);
+    }
+    // the arrays of a field are page aligned and contiguous
+    REQUIRE((size_t)&pool.get<1>(0) % getPageSize() == 0);
+    REQUIRE(&pool.get<1>(1) == &pool.get<1>(0) + 1);
+}
+
+TEST_CASE("Free slots are reused before a new chunk", "[SoAPool]") {
+    Particles pool;
+    vector<size_t> indices;
+    for (size_t i = 0; i < Particles::CHUNK_SIZE; ++i) {
+        indices.push_back(pool.allocate());
+    }
+    pool.deallocate(indices[10]);
+    REQUIRE_FALSE(pool.isLive(indices[10]));
+    REQUIRE(pool.allocate() == indices[10]);
+    REQUIRE(pool.getNumberOfChunks() == 1);
+    size_t next = pool.allocate();
+    REQUIRE(pool.getNumberOfChunks() == 2);
+    REQUIRE(next / Particles::CHUNK_SIZE == 1);
+    pool.deallocate(next);
+    // the empty chunk is released
+    REQUIRE(pool.getNumberOfChunks() == 1);
+    REQUIRE(pool.allocate() / Particles::CHUNK_SIZE == 1);
+    REQUIRE(pool.getNumberOfChunks() == 2);
+}
+
+TEST_CASE("forEachSpan gives the contiguous arrays of a field",
+          "[SoAPool]") {
+    SoAPool<float, float> pool;
+    vector<size_t> indices;
+    for (size_t i = 0; i < 2 * SoAPool<float, float>::CHUNK_SIZE + 7; ++i) {
+        size_t index = pool.allocate();
+        pool.get<0>(index) = 1.0f;
+        pool.get<1>(index) = (float)i;
+        indices.push_back(index);
+    }
+    // a kernel which the compiler can vectorise
+    pool.forEachSpan<0>([](float* t_x, size_t t_count, size_t) {
+        for (size_t i = 0; i < t_count; ++i) {
+            t_x[i] *= 3.0f;
+        }
+    });
+    size_t visited = 0;
+    pool.forEachSpan<1>([&](float* t_y, size_t t_count, size_t t_first) {
+        for (size_t i = 0; i < t_count; ++i) {
+            if (pool.isLive(t_first + i)) {
+                REQUIRE(t_y[i] == (float)(t_first + i));
+                ++visited;
+            }
+        }
+    });
+    REQUIRE(visited == indices.size());
+    for (auto index : indices) {
+        REQUIRE(pool.get<0>(index) == 3.0f);
+    }
+}
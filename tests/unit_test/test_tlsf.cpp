@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+using std::vector;
+
+#include "rpools/allocators/TLSF.hpp"
+using namespace rpools;
+
+TEST_CASE("Allocations are aligned and large enough", "[TLSF]") {
+    TLSF tlsf;
+    vector<void*> ptrs;
+    for (size_t size = 0; size <= 4096; size += 7) {
+        void* ptr = tlsf.allocate(size);
+        REQUIRE(ptr != nullptr);
+        REQUIRE((size_t)ptr % TLSF::ALIGNMENT == 0);
+        REQUIRE(TLSF::getBlockSize(ptr) >= size);
+        ptrs.push_back(ptr);
+    }
+    for (auto ptr : ptrs) {
+        tlsf.deallocate(ptr);
+    }
+}
+
+TEST_CASE("Allocations do not overlap", "[TLSF]") {
+    TLSF tlsf;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> sizes(129, 4096);
+    vector<std::pair<char*, size_t>> allocs;
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t size = sizes(gen);
+        auto ptr = static_cast<char*>(tlsf.allocate(size));
+        REQUIRE(ptr != nullptr);
+        std::memset(ptr, (int)(i % 256), size);
+        allocs.push_back({ ptr, size });
+        // free some of the allocations to create holes
+        if (i % 3 == 0) {
+            size_t index = gen() % allocs.size();
+            tlsf.deallocate(allocs[index].first);
+            allocs.erase(allocs.begin() + index);
+        }
+    }
+    std::sort(allocs.begin(), allocs.end());
+    for (size_t i = 1; i < allocs.size(); ++i) {
+        REQUIRE(allocs[i - 1].first + allocs[i - 1].second <=
+                allocs[i].first);
+    }
+    for (auto& alloc : allocs) {
+        tlsf.deallocate(alloc.first);
+    }
+}
+
+TEST_CASE("Freed neighbouring blocks are merged", "[TLSF]") {
+    TLSF tlsf(64 * 1024);
+    vector<void*> ptrs;
+    for (size_t i = 0; i < 16; ++i) {
+        ptrs.push_back(tlsf.allocate(1024));
+    }
+    REQUIRE(tlsf.getNumberOfSpans() == 1);
+    for (auto ptr : ptrs) {
+        tlsf.deallocate(ptr);
+    }
+    // the whole span is a single free block again
+    void* ptr = tlsf.allocate(tlsf.getMaxAllocation());
+    REQUIRE(ptr != nullptr);
+    REQUIRE(tlsf.getNumberOfSpans() == 1);
+    tlsf.deallocate(ptr);
+}
+
+TEST_CASE("Spans are added when needed and released when empty", "[TLSF]") {
+    TLSF tlsf(64 * 1024);
+    REQUIRE(tlsf.getNumberOfSpans() == 0);
+    REQUIRE(tlsf.allocate(tlsf.getMaxAllocation() + 1) == nullptr);
+    void* first = tlsf.allocate(tlsf.getMaxAllocation());
+    void* second = tlsf.allocate(tlsf.getMaxAllocation());
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+    REQUIRE(tlsf.getNumberOfSpans() == 2);
+    tlsf.deallocate(first);
+    REQUIRE(tlsf.getNumberOfSpans() == 1);
+    // the last span is kept
+    tlsf.deallocate(second);
+    REQUIRE(tlsf.getNumberOfSpans() == 1);
+}
+
+TEST_CASE("Freed blocks are reused", "[TLSF]") {
+    TLSF tlsf;
+    void* keep = tlsf.allocate(200);
+    void* ptr = tlsf.allocate(300);
+    tlsf.deallocate(ptr);
+    REQUIRE(tlsf.allocate(300) == ptr);
+    tlsf.deallocate(ptr);
+    tlsf.deallocate(keep);
+}
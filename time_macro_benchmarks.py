@@ -0,0 +1,119 @@
+#!/usr/bin/python3
+
+import argparse
+import json
+import os
+import subprocess
+import time
+
+
+# the name of every macro benchmark and the meaning of its arguments
+BENCHMARKS = {
+    'macro_json': ['RECORDS', 'ROUNDS'],
+    'macro_map': ['OPERATIONS'],
+    'macro_string': ['LINES', 'ROUNDS'],
+}
+
+
+def run(executable, args, preload):
+    '''
+    Run the given executable once and return a tuple which contains the
+    wall time (in seconds) and the peak RSS (in KBs) of the process.
+
+    If "preload" is not None, the executable is run with the given library
+    in LD_PRELOAD, just like "inject_custom_new" does.
+    '''
+    env = dict(os.environ)
+    if preload:
+        env['LD_PRELOAD'] = preload
+    start = time.perf_counter()
+    proc = subprocess.Popen([executable] + args, env=env,
+                            stdout=subprocess.DEVNULL)
+    # wait4 returns the resource usage of this child only
+    _, status, usage = os.wait4(proc.pid, 0)
+    elapsed = time.perf_counter() - start
+    if status != 0:
+        raise RuntimeError('%s exited with status %d' % (executable, status))
+    # ru_maxrss is already in KBs on Linux
+    return elapsed, usage.ru_maxrss
+
+
+def bench(executable, args, preload, repeat):
+    '''
+    Run the given executable "repeat" times and return the best wall time
+    and the largest peak RSS that were observed.
+    '''
+    times, rss = [], []
+    for _ in range(repeat):
+        elapsed, peak = run(executable, args, preload)
+        times.append(elapsed)
+        rss.append(peak)
+    return {'wall_time': min(times), 'peak_rss': max(rss)}
+
+
+def generate_table(folder, lib, repeat, bench_args):
+    '''
+    Run every macro benchmark normally and with "lib" preloaded.
+    "bench_args" maps the name of a benchmark to its own arguments.
+    '''
+    table = {}
+    for name in BENCHMARKS:
+        executable = os.path.join(folder, name)
+        args = bench_args.get(name) or []
+        print(' '.join([executable] + args))
+        table[name] = {
+            'normal': bench(executable, args, None, repeat),
+            'custom_new': bench(executable, args, lib, repeat)
+        }
+    return table
+
+
+def print_table(table):
+    '''
+    Print the given table (see "generate_table") in a human readable format.
+    '''
+    header = '%-14s %12s %12s %12s %12s' % ('benchmark', 'time (s)',
+                                            'time ratio', 'RSS (KBs)',
+                                            'RSS ratio')
+    print(header)
+    print('-' * len(header))
+    for name, results in table.items():
+        normal = results['normal']
+        custom = results['custom_new']
+        for kind, res in (('normal', normal), ('custom_new', custom)):
+            print('%-14s %12.3f %12.2f %12d %12.2f' % (
+                name if kind == 'normal' else '  custom_new',
+                res['wall_time'], res['wall_time'] / normal['wall_time'],
+                res['peak_rss'], res['peak_rss'] / normal['peak_rss']))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description='Run the macro benchmarks with and without libcustomnew'
+    )
+    parser.add_argument('--folder', '-f', help='The folder which contains '
+                        'the macro benchmarks (default: '
+                        './build/benchmarks/macro)',
+                        default='./build/benchmarks/macro')
+    parser.add_argument('--lib', '-l', help='The path of libcustomnew.so '
+                        '(default: /usr/local/lib/libcustomnew.so)',
+                        default='/usr/local/lib/libcustomnew.so')
+    parser.add_argument('--repeat', '-r', help='How many times each '
+                        'benchmark is run (default: 3)', type=int, default=3)
+    parser.add_argument('--output', '-o', help='Also write the results as '
+                        'JSON to the given file')
+    # the arguments mean different things in every benchmark
+    for name, meaning in BENCHMARKS.items():
+        option = name.replace('macro_', '')
+        parser.add_argument('--%s-args' % option, dest=name, nargs='+',
+                            metavar='ARG',
+                            help='Arguments of %s: %s' %
+                            (name, ' '.join('[%s]' % m for m in meaning)))
+    args = parser.parse_args()
+    bench_args = {name: getattr(args, name) for name in BENCHMARKS}
+    table = generate_table(args.folder, os.path.abspath(args.lib),
+                           args.repeat, bench_args)
+    print_table(table)
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(table, f, indent=4)
@@ -0,0 +1,104 @@
+#!/usr/bin/python3
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import time
+
+
+def run(executable, args, preload):
+    '''
+    Run the given executable once and return a tuple which contains the
+    wall time of the process (in ms) and its stdout.
+
+    If "preload" is not None, the executable is run with the given library
+    in LD_PRELOAD, just like "inject_custom_new" does.
+    '''
+    env = dict(os.environ)
+    if preload:
+        env['LD_PRELOAD'] = preload
+    start = time.perf_counter()
+    out = subprocess.run([executable] + args, env=env,
+                         stdout=subprocess.PIPE, check=True)
+    return (time.perf_counter() - start) * 1000, out.stdout
+
+
+def bench(executable, preload, repeat):
+    '''
+    Run "bench_first_alloc" "repeat" times and return the median of:
+    * the startup time of the process (in ms)
+    * the time it took to make the first allocation (in ns)
+    * the time it took to make the first and second allocation of each size
+      (in ns)
+    '''
+    startup, first_alloc = [], []
+    sizes = {}
+    for _ in range(repeat):
+        elapsed, _ = run(executable, ['--noop'], preload)
+        startup.append(elapsed)
+        _, out = run(executable, [], preload)
+        res = json.loads(out)
+        first_alloc.append(res['first_alloc_ns'])
+        for size, hits in res['sizes'].items():
+            entry = sizes.setdefault(int(size), {'first_ns': [],
+                                                 'second_ns': []})
+            entry['first_ns'].append(hits['first_ns'])
+            entry['second_ns'].append(hits['second_ns'])
+    return {
+        'startup_ms': statistics.median(startup),
+        'first_alloc_ns': statistics.median(first_alloc),
+        'sizes': {size: {key: statistics.median(val)
+                         for key, val in hits.items()}
+                  for size, hits in sorted(sizes.items())}
+    }
+
+
+def print_results(results):
+    '''
+    Print the results of "bench" with and without the preloaded library.
+    '''
+    normal, custom = results['normal'], results['custom_new']
+    print('%-24s %12s %12s' % ('', 'normal', 'custom_new'))
+    print('%-24s %12.3f %12.3f' % ('startup (ms)', normal['startup_ms'],
+                                   custom['startup_ms']))
+    print('%-24s %12d %12d' % ('first allocation (ns)',
+                               normal['first_alloc_ns'],
+                               custom['first_alloc_ns']))
+    print('first/second allocation of each size (ns):')
+    for size in normal['sizes']:
+        n, c = normal['sizes'][size], custom['sizes'][size]
+        print('%-24s %5d/%-6d %5d/%-6d' % ('  %d bytes' % size,
+                                           n['first_ns'], n['second_ns'],
+                                           c['first_ns'], c['second_ns']))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description='Measure the startup and first allocation latency with '
+        'and without libcustomnew'
+    )
+    parser.add_argument('--executable', '-e', help='The path of '
+                        'bench_first_alloc (default: '
+                        './build/benchmarks/startup/bench_first_alloc)',
+                        default='./build/benchmarks/startup/'
+                        'bench_first_alloc')
+    parser.add_argument('--lib', '-l', help='The path of libcustomnew.so '
+                        '(default: /usr/local/lib/libcustomnew.so)',
+                        default='/usr/local/lib/libcustomnew.so')
+    parser.add_argument('--repeat', '-r', help='How many times each '
+                        'measurement is made (default: 50)', type=int,
+                        default=50)
+    parser.add_argument('--output', '-o', help='Also write the results as '
+                        'JSON to the given file')
+    args = parser.parse_args()
+    results = {
+        'normal': bench(args.executable, None, args.repeat),
+        'custom_new': bench(args.executable, os.path.abspath(args.lib),
+                            args.repeat)
+    }
+    print_results(results)
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(results, f, indent=4)